@@ -20,6 +20,7 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "defs.h"
+#include "pgstat.h"
 #include "proc.h"
 
 #define BACKSPACE 0x100
@@ -84,6 +85,8 @@ consoleread(int user_dst, uint64 dst, int n)
   char cbuf;
 
   target = n;
+  if(user_dst)
+    uvmprefault(dst, n);
   acquire(&cons.lock);
   while(n > 0){
     // wait until interrupt handler has put some
@@ -9,6 +9,9 @@ struct sleeplock;
 struct stat;
 struct superblock;
 struct memory_page_entry;
+struct pgindex;
+struct kmem_cache;
+struct memstat;
 struct swap_file_entry;
 struct paging_metadata;
 
@@ -44,6 +47,10 @@ int             dirlink(struct inode*, char*, uint);
 struct inode*   dirlookup(struct inode*, char*, uint*);
 struct inode*   ialloc(uint, short);
 struct inode*   idup(struct inode*);
+int             igetwrite(struct inode*);
+void            iputwrite(struct inode*);
+int             idenywrite(struct inode*);
+void            iallowwrite(struct inode*);
 void            iinit();
 void            ilock(struct inode*);
 void            iput(struct inode*);
@@ -57,11 +64,6 @@ int             readi(struct inode*, int, uint64, uint, uint);
 void            stati(struct inode*, struct stat*);
 int             writei(struct inode*, int, uint64, uint, uint);
 void            itrunc(struct inode*);
-int		        createSwapFile(struct proc* p);
-int	          	readFromSwapFile(struct proc * p, char* buffer, uint placeOnFile, uint size);
-int		        writeToSwapFile(struct proc* p, char* buffer, uint placeOnFile, uint size);
-int		        removeSwapFile(struct proc* p);
-int             copy_swap_file(struct proc *from, struct proc *to);
 
 // ramdisk.c
 void            ramdiskinit(void);
@@ -71,6 +73,19 @@ void            ramdiskrw(struct buf*);
 // kalloc.c
 void*           kalloc(void);
 void            kfree(void *);
+void            kdup(void *);
+int             krefcnt(void *);
+void*           kalloc_order(int);
+void            kfree_order(void *, int);
+int             kfreepages(void);
+int             getmemstat(uint64);
+
+// slab.c
+void            slabinit(void);
+struct kmem_cache* kmem_cache_create(char*, int);
+void*           kmem_cache_alloc(struct kmem_cache*);
+void            kmem_cache_free(struct kmem_cache*, void*);
+int             getslabstat(int, uint64);
 void            kinit(void);
 
 // log.c
@@ -80,6 +95,7 @@ void            begin_op(void);
 void            end_op(void);
 
 // pipe.c
+void            pipeinit(void);
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
 int             piperead(struct pipe*, uint64, int);
@@ -109,12 +125,50 @@ void            scheduler(void) __attribute__((noreturn));
 void            sched(void);
 void            sleep(void*, struct spinlock*);
 void            userinit(void);
+void            kthread_create(void (*)(void), char*);
 int             wait(uint64);
 void            wakeup(void*);
 void            yield(void);
 int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
 void            procdump(void);
+int             getpgstat(int, uint64);
+
+// swap.c
+void            swapinit(void);
+int             swap_alloc(void);
+int             swap_alloc_cluster(int);
+void            swap_dup(int);
+void            swap_free(int);
+void            swap_read(int, void*);
+void            swap_write(int, void*);
+void            swap_writev(int, void**, int);
+void*           swap_cache_take(int);
+void            swap_readahead(int*, int);
+
+// shm.c
+void            shminit(void);
+int             shmget(int, int);
+uint64          shmat(int, uint64);
+int             shmdt(uint64);
+void            shmdetachall(struct proc*, pagetable_t);
+int             shmfork(struct proc*, struct proc*);
+
+// ksm.c
+void            ksminit(void);
+void*           ksm_zeropage(void);
+void            ksm_tick(struct proc*);
+void            ksm_stat(struct memstat*);
+
+// zswap.c
+void            zswapinit(void);
+int             zswap_store(int, void*);
+int             zswap_load(int, void*);
+int             zswap_has(int);
+void            zswap_drop(int);
+void            zswap_unstore(int);
+void            zswap_miss(int);
+void            zswap_stat(struct memstat*);
 
 // swtch.S
 void            swtch(struct context*, struct context*);
@@ -173,6 +227,7 @@ void            kvminit(void);
 void            kvminithart(void);
 void            kvmmap(pagetable_t, uint64, uint64, uint64, int);
 int             mappages(pagetable_t, uint64, uint64, uint64, int);
+int             mapmegapages(pagetable_t, uint64, uint64, uint64, int);
 pagetable_t     uvmcreate(void);
 void            uvmfirst(pagetable_t, uchar *, uint);
 uint64          uvmalloc(pagetable_t, uint64, uint64, int);
@@ -180,12 +235,18 @@ uint64          uvmdealloc(pagetable_t, uint64, uint64);
 int             uvmcopy(pagetable_t, pagetable_t, uint64);
 void            uvmfree(pagetable_t, uint64);
 void            uvmunmap(pagetable_t, uint64, uint64, int);
+void            uvmflush(pagetable_t, uint64, uint64);
 void            uvmclear(pagetable_t, uint64);
 pte_t *         walk(pagetable_t, uint64, int);
 uint64          walkaddr(pagetable_t, uint64);
 int             copyout(pagetable_t, uint64, char *, uint64);
 int             copyin(pagetable_t, char *, uint64, uint64);
 int             copyinstr(pagetable_t, char *, uint64, uint64);
+int             uvmiscow(pagetable_t, uint64);
+int             cow_fault(pagetable_t, uint64);
+int             uvmislazy(struct proc*, uint64);
+int             lazy_alloc(struct proc*, uint64, int);
+int             uvmprefault(uint64, uint64);
 //task2
 int             remove_page_from_memory(struct proc*, uint64);
 int             remove_page_from_swapfile(struct proc*, uint64);
@@ -194,13 +255,38 @@ int             swap_out_memory(struct proc*);
 int             swap_in_memory(struct proc*, uint64);
 void            print_memory(struct proc*);
 void            print_swap_file(struct proc*);
-void            update_age(struct proc*);
+void            dup_swap_entries(struct proc*);
+void            free_swap_entries(struct pgindex*);
+void            free_clean_pages(struct pgindex*);
+void            preclean(struct proc*);
+void            pageoutinit(void);
+void            pageoutd(void);
+int             index_to_evict(struct proc*);
+int             set_paging_limits(int, int);
+int             madvise(uint64, uint64, int);
+struct madvrange* madv_find(struct proc*, uint64);
+void            reclaim_setcold(struct proc*, int);
+void            reclaim_tick(struct proc*);
+
+// pgindex.c
+void            pgindex_init(struct pgindex*, int, int);
+void            pgindex_free(struct pgindex*);
+int             pgindex_setlimit(struct pgindex*, int);
+void*           pgindex_get(struct pgindex*, int);
+int             pgindex_find(struct pgindex*, uint64);
+int             pgindex_add(struct pgindex*, uint64);
+void            pgindex_remove(struct pgindex*, int);
+int             pgindex_next(struct pgindex*, int);
+int             pgindex_copy(struct pgindex*, struct pgindex*);
+
+// swappolicy.c
 int             index_to_swap(struct proc*);
-int             index_to_swap_NFUA(struct proc*);
-int             index_to_swap_LAPA(struct proc*);
-int             index_to_swap_SCFIFO(struct proc*);
-int             countSetBits(uint);
-int             find_min_order(struct proc*);
+void            policy_add(struct proc*, struct memory_page_entry*);
+void            policy_evict(struct proc*, struct memory_page_entry*);
+void            policy_tick(struct proc*);
+void            policy_reset(struct proc*);
+void            policy_restart(struct proc*);
+int             set_swap_policy(int);
 
 // plic.c
 void            plicinit(void);
@@ -211,6 +297,7 @@ void            plic_complete(int);
 // virtio_disk.c
 void            virtio_disk_init(void);
 void            virtio_disk_rw(struct buf *, int);
+void            virtio_disk_rwraw(uint64, void **, int, uint, int);
 void            virtio_disk_intr(void);
 
 // number of elements in fixed-size array
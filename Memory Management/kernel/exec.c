@@ -3,8 +3,12 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "pgstat.h"
 #include "proc.h"
 #include "defs.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
 #include "elf.h"
 
 static int loadseg(pde_t *, uint64, struct inode *, uint, uint);
@@ -30,41 +34,22 @@ exec(char *path, char **argv)
   struct proghdr ph;
   pagetable_t pagetable = 0, oldpagetable;
   struct proc *p = myproc();
+  struct inode *exe = 0, *oldexe;
+  struct execseg seg[NEXECSEG];
+  int nseg = 0;
 
 
   //task2
   //backing up the metadate
   #ifndef NONE
   struct paging_metadata *pmd =&p->paging_metadata;
-  int num_in_memory = pmd->num_in_memory;
-  int num_in_swapfile = pmd->num_in_swap;
   int order_counter = pmd->order_counter;
-  struct memory_page_entry b_memory_page_entries[MAX_PSYC_PAGES];
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    b_memory_page_entries[i] = pmd->memory_page_entries[i];
-  }
-  struct swap_file_entry b_swap_file_entries[MAX_TOTAL_PAGES-MAX_PSYC_PAGES];
-  for(int i=0; i< MAX_TOTAL_PAGES-MAX_PSYC_PAGES; i++){
-    b_swap_file_entries[i] = pmd->swap_file_entries[i];
-  }
+  struct pgindex b_mem = pmd->mem;
+  struct pgindex b_swap = pmd->swap;
 
-  pmd->num_in_memory = 0;
-  pmd->num_in_swap = 0;
-  pmd->order_counter = 0;
-  for(int i=0; i< MAX_TOTAL_PAGES-MAX_PSYC_PAGES; i++){
-    struct swap_file_entry *sfe = &pmd->swap_file_entries[i];
-    sfe->va = 0;
-    sfe->offset = 0;
-    sfe->present = 0;
-  }
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    struct memory_page_entry *mpe = &pmd->memory_page_entries[i];
-    mpe->present = 0;
-    mpe->va = 0;
-    mpe->age = 0;
-    mpe->offset = 0;
-    mpe->order = 0;
-  }
+  // the new image starts with empty indexes, at the same limits.
+  pgindex_init(&pmd->mem, b_mem.esz, b_mem.limit);
+  pgindex_init(&pmd->swap, b_swap.esz, b_swap.limit);
   #endif
 
 
@@ -97,10 +82,25 @@ exec(char *path, char **argv)
       continue;
     if(ph.memsz < ph.filesz)
       goto bad;
-    if(ph.vaddr + ph.memsz < ph.vaddr)
+    if(ph.vaddr + ph.memsz < ph.vaddr || ph.vaddr + ph.memsz > SHMBASE)
       goto bad;
     if(ph.vaddr % PGSIZE != 0)
       goto bad;
+    if(ph.off + ph.filesz < ph.off || ph.off + ph.filesz > ip->size)
+      goto bad;
+    if(nseg < NEXECSEG){
+      // map nothing yet; lazy_alloc() reads each page
+      // from ip when the program first touches it.
+      seg[nseg].va = ph.vaddr;
+      seg[nseg].filesz = ph.filesz;
+      seg[nseg].memsz = ph.memsz;
+      seg[nseg].off = ph.off;
+      seg[nseg].perm = flags2perm(ph.flags);
+      nseg++;
+      if(ph.vaddr + ph.memsz > sz)
+        sz = ph.vaddr + ph.memsz;
+      continue;
+    }
     uint64 sz1;
     if((sz1 = uvmalloc(pagetable, sz, ph.vaddr + ph.memsz, flags2perm(ph.flags))) == 0)
       goto bad;
@@ -108,6 +108,9 @@ exec(char *path, char **argv)
     if(loadseg(pagetable, ph.vaddr, ip, ph.off, ph.filesz) < 0)
       goto bad;
   }
+  if(idenywrite(ip) < 0)
+    goto bad;   // open for writing
+  exe = idup(ip);
   iunlockput(ip);
   end_op();
   ip = 0;
@@ -162,19 +165,36 @@ exec(char *path, char **argv)
 
   //task2
   #ifndef NONE
-  if(p->pid>2 && !(p->name[0]=='s' && p->name[1]=='h' && p->name[3]=='\000')){
-    removeSwapFile(p);
-    createSwapFile(p);
-  }
+  free_swap_entries(&b_swap);
+  free_clean_pages(&b_mem);
+  pgindex_free(&b_swap);
+  pgindex_free(&b_mem);
+  // the policy, read-ahead, advice and reclaim state described
+  // the old image; start them over with the pages exec mapped.
+  pmd->ra_window = 0;
+  pmd->nmadv = 0;
+  reclaim_setcold(p, 0);
+  policy_restart(p);
   #endif
     
   // Commit to the user image.
   oldpagetable = p->pagetable;
+  oldexe = p->exe;
   p->pagetable = pagetable;
   p->sz = sz;
+  p->exe = exe;
+  p->nseg = nseg;
+  memmove(p->seg, seg, sizeof(seg));
   p->trapframe->epc = elf.entry;  // initial program counter = main
   p->trapframe->sp = sp; // initial stack pointer
+  shmdetachall(p, oldpagetable);
   proc_freepagetable(oldpagetable, oldsz);
+  if(oldexe){
+    iallowwrite(oldexe);
+    begin_op();
+    iput(oldexe);
+    end_op();
+  }
 
   return argc; // this ends up in a0, the first argument to main(argc, argv)
 
@@ -185,18 +205,24 @@ exec(char *path, char **argv)
     iunlockput(ip);
     end_op();
   }
+  if(exe){
+    iallowwrite(exe);
+    begin_op();
+    iput(exe);
+    end_op();
+  }
 
   #ifndef NONE
   //task2 - restore the metadata
-  pmd->num_in_memory = num_in_memory;
-  pmd->num_in_swap = num_in_swapfile;
+  // the failed image's pages were freed with its pagetable;
+  // drop its swap slots and entries.
+  free_swap_entries(&pmd->swap);
+  free_clean_pages(&pmd->mem);
+  pgindex_free(&pmd->swap);
+  pgindex_free(&pmd->mem);
   pmd->order_counter = order_counter;
-  for(int i=0; i< MAX_TOTAL_PAGES-MAX_PSYC_PAGES; i++){
-    pmd->swap_file_entries[i]=b_swap_file_entries[i];
-  }
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    pmd->memory_page_entries[i]= b_memory_page_entries[i];
-  }
+  pmd->mem = b_mem;
+  pmd->swap = b_swap;
   #endif
 
   return -1;
@@ -11,6 +11,7 @@
 #include "sleeplock.h"
 #include "file.h"
 #include "stat.h"
+#include "pgstat.h"
 #include "proc.h"
 
 struct devsw devsw[NDEV];
@@ -76,6 +77,8 @@ fileclose(struct file *f)
   if(ff.type == FD_PIPE){
     pipeclose(ff.pipe, ff.writable);
   } else if(ff.type == FD_INODE || ff.type == FD_DEVICE){
+    if(ff.type == FD_INODE && ff.writable)
+      iputwrite(ff.ip);
     begin_op();
     iput(ff.ip);
     end_op();
@@ -118,6 +121,9 @@ fileread(struct file *f, uint64 addr, int n)
       return -1;
     r = devsw[f->major].read(1, addr, n);
   } else if(f->type == FD_INODE){
+    // readi() copies out under the inode lock.
+    if(uvmprefault(addr, n) < 0)
+      return -1;
     ilock(f->ip);
     if((r = readi(f->ip, 1, addr, f->off, n)) > 0)
       f->off += r;
@@ -154,6 +160,9 @@ filewrite(struct file *f, uint64 addr, int n)
     // might be writing a device like the console.
     int max = ((MAXOPBLOCKS-1-1-2) / 2) * BSIZE;
     int i = 0;
+    // writei() copies in under the inode lock.
+    if(uvmprefault(addr, n) < 0)
+      return -1;
     while(i < n){
       int n1 = n - i;
       if(n1 > max)
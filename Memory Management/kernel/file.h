@@ -18,6 +18,7 @@ struct inode {
   uint dev;           // Device number
   uint inum;          // Inode number
   int ref;            // Reference count
+  int writers;        // >0 open for writing, <0 running programs
   struct sleeplock lock; // protects everything below here
   int valid;          // inode has been read from disk?
 
@@ -15,6 +15,7 @@
 #include "param.h"
 #include "stat.h"
 #include "spinlock.h"
+#include "pgstat.h"
 #include "proc.h"
 #include "sleeplock.h"
 #include "fs.h"
@@ -43,6 +44,8 @@ fsinit(int dev) {
   readsb(dev, &sb);
   if(sb.magic != FSMAGIC)
     panic("invalid file system");
+  if(sb.nswap < NSWAPPAGES)
+    panic("fsinit: no swap area");
   initlog(dev, &sb);
 }
 
@@ -287,6 +290,55 @@ idup(struct inode *ip)
   return ip;
 }
 
+// A program's pages are read from its file as it first touches
+// them, so a file can't be written while it runs, nor run while
+// it is open for writing. igetwrite() and idenywrite() claim ip
+// for one more writer or program, or return -1 if the other
+// kind holds it; iputwrite() and iallowwrite() undo them.
+int
+igetwrite(struct inode *ip)
+{
+  int r = -1;
+
+  acquire(&itable.lock);
+  if(ip->writers >= 0){
+    ip->writers++;
+    r = 0;
+  }
+  release(&itable.lock);
+  return r;
+}
+
+void
+iputwrite(struct inode *ip)
+{
+  acquire(&itable.lock);
+  ip->writers--;
+  release(&itable.lock);
+}
+
+int
+idenywrite(struct inode *ip)
+{
+  int r = -1;
+
+  acquire(&itable.lock);
+  if(ip->writers <= 0){
+    ip->writers--;
+    r = 0;
+  }
+  release(&itable.lock);
+  return r;
+}
+
+void
+iallowwrite(struct inode *ip)
+{
+  acquire(&itable.lock);
+  ip->writers++;
+  release(&itable.lock);
+}
+
 // Lock the given inode.
 // Reads the inode from disk if necessary.
 void
@@ -695,161 +747,3 @@ nameiparent(char *path, char *name)
 {
   return namex(path, 1, name);
 }
-
-
-#include "fcntl.h"
-#define DIGITS 14
-
-char* itoa(int i, char b[]){
-    char const digit[] = "0123456789";
-    char* p = b;
-    if(i<0){
-        *p++ = '-';
-        i *= -1;
-    }
-    int shifter = i;
-    do{ //Move to where representation ends
-        ++p;
-        shifter = shifter/10;
-    }while(shifter);
-    *p = '\0';
-    do{ //Move back, inserting digits as u go
-        *--p = digit[i%10];
-        i = i/10;
-    }while(i);
-    return b;
-}
-//remove swap file of proc p;
-int
-removeSwapFile(struct proc* p)
-{
-  //path of proccess
-  char path[DIGITS];
-  memmove(path,"/.swap", 6);
-  itoa(p->pid, path+ 6);
-
-  struct inode *ip, *dp;
-  struct dirent de;
-  char name[DIRSIZ];
-  uint off;
-
-  if(0 == p->swapFile)
-  {
-    return -1;
-  }
-  fileclose(p->swapFile);
-
-  begin_op();
-  if((dp = nameiparent(path, name)) == 0)
-  {
-    end_op();
-    return -1;
-  }
-
-  ilock(dp);
-
-    // Cannot unlink "." or "..".
-  if(namecmp(name, ".") == 0 || namecmp(name, "..") == 0)
-     goto bad;
-
-  if((ip = dirlookup(dp, name, &off)) == 0)
-    goto bad;
-  ilock(ip);
-
-  if(ip->nlink < 1)
-    panic("unlink: nlink < 1");
-  if(ip->type == T_DIR && !isdirempty(ip)){
-    iunlockput(ip);
-    goto bad;
-  }
-
-  memset(&de, 0, sizeof(de));
-  if(writei(dp,0, (uint64)&de, off, sizeof(de)) != sizeof(de))
-    panic("unlink: writei");
-  if(ip->type == T_DIR){
-    dp->nlink--;
-    iupdate(dp);
-  }
-  iunlockput(dp);
-
-  ip->nlink--;
-  iupdate(ip);
-  iunlockput(ip);
-
-  end_op();
-
-  return 0;
-
-  bad:
-    iunlockput(dp);
-    end_op();
-    return -1;
-
-}
-
-
-//return 0 on success
-int
-createSwapFile(struct proc* p)
-{
-
-  char path[DIGITS];
-  memmove(path,"/.swap", 6);
-  itoa(p->pid, path+ 6);
-
-  begin_op();
-  
-  struct inode * in = create(path, T_FILE, 0, 0);
-  iunlock(in);
-  p->swapFile = filealloc();
-  if (p->swapFile == 0)
-    panic("no slot for files on /store");
-
-  p->swapFile->ip = in;
-  p->swapFile->type = FD_INODE;
-  p->swapFile->off = 0;
-  p->swapFile->readable = O_WRONLY;
-  p->swapFile->writable = O_RDWR;
-    end_op();
-
-    return 0;
-}
-
-//return as sys_write (-1 when error)
-int
-writeToSwapFile(struct proc * p, char* buffer, uint placeOnFile, uint size)
-{
-  p->swapFile->off = placeOnFile;
-  return kfilewrite(p->swapFile, (uint64)buffer, size);
-}
-
-//return as sys_read (-1 when error)
-int
-readFromSwapFile(struct proc * p, char* buffer, uint placeOnFile, uint size)
-{
-  p->swapFile->off = placeOnFile;
-  return kfileread(p->swapFile, (uint64)buffer,  size);
-}
-
-
-//task2
-int
-copy_swap_file(struct proc *from, struct proc *to){
-  //printf("in copy_swap_file\n");
-  //print_swap_file(from);
-  //print_swap_file(to);
-  char* buffer = kalloc();
-  for(int i=0; i< MAX_TOTAL_PAGES-MAX_PSYC_PAGES; i++){
-    if(readFromSwapFile(from, buffer, PGSIZE*i, PGSIZE) != PGSIZE){
-      //printf("copy_swap_file: readFromSwapFile failed in i=%d\n", i);
-      break;
-    }
-    if(writeToSwapFile(to, buffer, PGSIZE*i, PGSIZE) != PGSIZE){
-      printf("copy_swap_file: writeToSwapFile failed in i=%d\n", i);
-      return -1;
-    }
-  }
-  kfree(buffer);
-
-  return 0;
-}
\ No newline at end of file
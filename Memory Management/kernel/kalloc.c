@@ -1,6 +1,15 @@
 // Physical memory allocator, for user processes,
 // kernel stacks, page-table pages,
-// and pipe buffers. Allocates whole 4096-byte pages.
+// and pipe buffers. Allocates whole 4096-byte pages,
+// or blocks of 2^order contiguous pages.
+//
+// A binary buddy allocator: free memory is kept in blocks of
+// 2^order pages, aligned to their size, on one list per order.
+// An allocation splits the smallest free block that fits, and a
+// free merges the block with its buddy, the other half of the
+// block of the next order, for as long as that buddy is free.
+// kalloc() and kfree() work on single pages, which need no
+// splitting as long as order 0 has free blocks.
 
 #include "types.h"
 #include "param.h"
@@ -8,57 +17,189 @@
 #include "spinlock.h"
 #include "riscv.h"
 #include "defs.h"
+#include "memstat.h"
 
 void freerange(void *pa_start, void *pa_end);
 
 extern char end[]; // first address after kernel.
                    // defined by kernel.ld.
 
+#define NPHYS ((PHYSTOP-KERNBASE)/PGSIZE)
+#define NOTFREE 0xff
+
 struct run {
   struct run *next;
+  struct run *prev;
 };
 
 struct {
   struct spinlock lock;
-  struct run *freelist;
+  struct run free[MAXORDER];   // list heads, circular
+  uchar order[NPHYS];          // order of the free block at each page, or NOTFREE
+  struct memstat st;
 } kmem;
 
+// reference counts of physical pages, so that copy-on-write
+// fork can map one page into several page tables.
+// a page goes back on the free list when its count drops to 0.
+struct {
+  struct spinlock lock;
+  int count[(PHYSTOP-KERNBASE)/PGSIZE];
+} kref;
+
+#define PA2REF(pa) (((uint64)(pa) - KERNBASE) / PGSIZE)
+#define REF2PA(i) ((void*)(KERNBASE + (uint64)(i) * PGSIZE))
+
 void
 kinit()
 {
   initlock(&kmem.lock, "kmem");
+  initlock(&kref.lock, "kref");
+  for(int k = 0; k < MAXORDER; k++)
+    kmem.free[k].next = kmem.free[k].prev = &kmem.free[k];
+  memset(kmem.order, NOTFREE, sizeof(kmem.order));
   freerange(end, (void*)PHYSTOP);
 }
 
+// Put the free block at page i on the list of order k.
+// Caller holds kmem.lock.
+static void
+push(uint64 i, int k)
+{
+  struct run *r = REF2PA(i);
+
+  r->next = kmem.free[k].next;
+  r->prev = &kmem.free[k];
+  r->next->prev = r;
+  kmem.free[k].next = r;
+  kmem.order[i] = k;
+  kmem.st.nfree[k]++;
+  kmem.st.nfreepages += 1L << k;
+}
+
+// Take the free block at page i off the list of order k.
+static void
+unlink(uint64 i, int k)
+{
+  struct run *r = REF2PA(i);
+
+  r->prev->next = r->next;
+  r->next->prev = r->prev;
+  kmem.order[i] = NOTFREE;
+  kmem.st.nfree[k]--;
+  kmem.st.nfreepages -= 1L << k;
+}
+
+// Free the block of order k at page i, merging it with
+// its buddies. Caller holds kmem.lock.
+static void
+buddy_free(uint64 i, int k)
+{
+  uint64 b;
+
+  for(; k < MAXORDER-1; k++){
+    b = i ^ (1L << k);
+    if(b + (1L << k) > NPHYS || kmem.order[b] != k)
+      break;
+    unlink(b, k);
+    kmem.st.nmerge++;
+    if(b < i)
+      i = b;
+  }
+  push(i, k);
+}
+
+// Allocate a block of order k, splitting a larger one if
+// need be. Returns its first page, or -1.
+static long
+buddy_alloc(int k)
+{
+  int j;
+  uint64 i;
+
+  for(j = k; j < MAXORDER; j++){
+    if(kmem.free[j].next != &kmem.free[j])
+      break;
+  }
+  if(j == MAXORDER){
+    kmem.st.nfail[k]++;
+    return -1;
+  }
+  i = PA2REF(kmem.free[j].next);
+  unlink(i, j);
+  // give back the upper halves.
+  while(j > k){
+    j--;
+    push(i + (1L << j), j);
+    kmem.st.nsplit++;
+  }
+  kmem.st.nalloc[k]++;
+  return i;
+}
+
 void
 freerange(void *pa_start, void *pa_end)
 {
   char *p;
   p = (char*)PGROUNDUP((uint64)pa_start);
-  for(; p + PGSIZE <= (char*)pa_end; p += PGSIZE)
+  for(; p + PGSIZE <= (char*)pa_end; p += PGSIZE){
+    kref.count[PA2REF(p)] = 1;
+    kmem.st.npages++;
     kfree(p);
+  }
 }
 
-// Free the page of physical memory pointed at by pa,
+// Add a reference to the allocated page pa.
+void
+kdup(void *pa)
+{
+  if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
+    panic("kdup");
+
+  acquire(&kref.lock);
+  if(kref.count[PA2REF(pa)] < 1)
+    panic("kdup: free page");
+  kref.count[PA2REF(pa)]++;
+  release(&kref.lock);
+}
+
+// Return the number of references to page pa.
+int
+krefcnt(void *pa)
+{
+  int n;
+
+  acquire(&kref.lock);
+  n = kref.count[PA2REF(pa)];
+  release(&kref.lock);
+  return n;
+}
+
+// Drop a reference to the page of physical memory pointed at by pa,
 // which normally should have been returned by a
-// call to kalloc().  (The exception is when
-// initializing the allocator; see kinit above.)
+// call to kalloc(), and free it once nothing refers to it.
+// (The exception is when initializing the allocator;
+// see kinit above.)
 void
 kfree(void *pa)
 {
-  struct run *r;
-
   if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
     panic("kfree");
 
+  acquire(&kref.lock);
+  if(kref.count[PA2REF(pa)] < 1)
+    panic("kfree: free page");
+  if(--kref.count[PA2REF(pa)] > 0){
+    release(&kref.lock);
+    return;
+  }
+  release(&kref.lock);
+
   // Fill with junk to catch dangling refs.
   memset(pa, 1, PGSIZE);
 
-  r = (struct run*)pa;
-
   acquire(&kmem.lock);
-  r->next = kmem.freelist;
-  kmem.freelist = r;
+  buddy_free(PA2REF(pa), 0);
   release(&kmem.lock);
 }
 
@@ -68,15 +209,84 @@ kfree(void *pa)
 void *
 kalloc(void)
 {
-  struct run *r;
+  return kalloc_order(0);
+}
+
+// Allocate 2^order physically contiguous pages, aligned to
+// their size. The block has one reference, like a kalloc()
+// page, but only kfree_order() may free it if order > 0.
+// Returns 0 if there is no free block that large.
+void *
+kalloc_order(int order)
+{
+  long i;
+  void *pa;
 
+  if(order < 0 || order >= MAXORDER)
+    return 0;
   acquire(&kmem.lock);
-  r = kmem.freelist;
-  if(r)
-    kmem.freelist = r->next;
+  i = buddy_alloc(order);
   release(&kmem.lock);
+  if(i < 0)
+    return 0;
+
+  pa = REF2PA(i);
+  memset(pa, 5, PGSIZE << order); // fill with junk
+  acquire(&kref.lock);
+  kref.count[i] = 1;
+  release(&kref.lock);
+  return pa;
+}
+
+// Free a block returned by kalloc_order(order).
+void
+kfree_order(void *pa, int order)
+{
+  if(order == 0){
+    kfree(pa);
+    return;
+  }
+  if(order < 0 || order >= MAXORDER ||
+     ((uint64)pa % (PGSIZE << order)) != 0 || (char*)pa < end ||
+     (uint64)pa + (PGSIZE << order) > PHYSTOP)
+    panic("kfree_order");
+
+  acquire(&kref.lock);
+  if(kref.count[PA2REF(pa)] != 1)
+    panic("kfree_order: shared");
+  kref.count[PA2REF(pa)] = 0;
+  release(&kref.lock);
+
+  memset(pa, 1, PGSIZE << order);
 
-  if(r)
-    memset((char*)r, 5, PGSIZE); // fill with junk
-  return (void*)r;
+  acquire(&kmem.lock);
+  buddy_free(PA2REF(pa), order);
+  release(&kmem.lock);
+}
+
+// The number of free pages.
+int
+kfreepages(void)
+{
+  int n;
+
+  acquire(&kmem.lock);
+  n = kmem.st.nfreepages;
+  release(&kmem.lock);
+  return n;
+}
+
+// Copy the allocator counters out to addr in the caller's
+// address space.
+int
+getmemstat(uint64 addr)
+{
+  struct memstat st;
+
+  acquire(&kmem.lock);
+  st = kmem.st;
+  release(&kmem.lock);
+  zswap_stat(&st);
+  ksm_stat(&st);
+  return either_copyout(1, addr, &st, sizeof(st));
 }
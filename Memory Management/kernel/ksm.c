@@ -0,0 +1,197 @@
+// Shared zero page and same-page merging.
+//
+// A read of an untouched page that would be all zeros maps the
+// zero page, read-only and copy-on-write, instead of a new page
+// of its own; see lazy_alloc(). The first write copies it.
+//
+// With KSMINTERVAL set, ksm_tick() also runs from the timer
+// interrupt every KSMINTERVAL ticks that a process spends in
+// user space, and hashes the next KSMSCAN of its resident pages.
+// A page that is all zeros is remapped to the zero page. A page
+// that hashed the same on the previous scan, and so is probably
+// not being written, is looked up in a table of NKSM shared
+// pages; if one has the same contents the page is remapped to
+// it copy-on-write and its own frame freed. Otherwise the page
+// itself becomes shared: it is made copy-on-write and the table
+// takes a reference to it, so that it cannot change while it is
+// there. Pages nobody else maps are dropped from the table again.
+//
+// Scanning a process's pages from its own timer interrupt means
+// nothing else can be changing its page table meanwhile.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "pgstat.h"
+#include "proc.h"
+#include "defs.h"
+#include "memstat.h"
+
+struct {
+  struct spinlock lock;
+  char *zero;            // the zero page
+  uint zerohash;
+  struct {
+    uint hash;
+    uint64 pa;           // 0 if unused
+  } page[NKSM];
+  int next;              // round-robin replacement
+  int prune;             // next entry to check for dropping
+  uint scanned;
+  uint merged;
+} ksm;
+
+static uint
+pagehash(uint64 *w)
+{
+  uint64 h = 14695981039346656037UL;
+
+  for(int i = 0; i < PGSIZE/8; i++)
+    h = (h ^ w[i]) * 1099511628211UL;
+  return h ^ (h >> 32);
+}
+
+void
+ksminit(void)
+{
+  initlock(&ksm.lock, "ksm");
+  if((ksm.zero = kalloc()) == 0)
+    panic("ksminit");
+  memset(ksm.zero, 0, PGSIZE);
+  ksm.zerohash = pagehash((uint64*)ksm.zero);
+}
+
+// The zero page. Its own reference is never dropped.
+void*
+ksm_zeropage(void)
+{
+  return ksm.zero;
+}
+
+// Make the user page at va, mapped by pte, copy-on-write.
+static void
+makecow(struct proc *p, uint64 va, pte_t *pte)
+{
+  if(*pte & PTE_W){
+    *pte = (*pte & ~PTE_W) | PTE_COW;
+    uvmflush(p->pagetable, va, 1);
+  }
+}
+
+// Remap the user page at va to pa, which has the same contents.
+static void
+merge(struct proc *p, uint64 va, pte_t *pte, uint64 pa)
+{
+  uint64 old = PTE2PA(*pte);
+  uint flags = PTE_FLAGS(*pte);
+
+  if(flags & PTE_W)
+    flags = (flags & ~PTE_W) | PTE_COW;
+  kdup((void*)pa);
+  *pte = PA2PTE(pa) | flags;
+  uvmflush(p->pagetable, va, 1);
+  kfree((void*)old);
+  ksm.merged++;
+}
+
+// Look at one resident page of p. Caller holds ksm.lock.
+static void
+scan(struct proc *p, struct memory_page_entry *mpe)
+{
+  pte_t *pte = walk(p->pagetable, mpe->va, 0);
+  uint64 pa;
+  uint h;
+  int i;
+
+  // a cleaned page's swap copy is tied to its frame.
+  if(mpe->cleaned || pte == 0 || (*pte & (PTE_V|PTE_U)) != (PTE_V|PTE_U))
+    return;
+  pa = PTE2PA(*pte);
+  if(pa == (uint64)ksm.zero)
+    return;
+  h = pagehash((uint64*)pa);
+  ksm.scanned++;
+  if(h == ksm.zerohash && memcmp((void*)pa, ksm.zero, PGSIZE) == 0){
+    merge(p, mpe->va, pte, (uint64)ksm.zero);
+    return;
+  }
+  if(h != mpe->ksmhash){
+    // changed since the last scan, or never scanned.
+    mpe->ksmhash = h;
+    return;
+  }
+
+  for(i = 0; i < NKSM; i++){
+    if(ksm.page[i].pa == 0 || ksm.page[i].hash != h)
+      continue;
+    if(ksm.page[i].pa == pa)
+      return;
+    if(memcmp((void*)pa, (void*)ksm.page[i].pa, PGSIZE) == 0){
+      merge(p, mpe->va, pte, ksm.page[i].pa);
+      return;
+    }
+  }
+
+  for(i = 0; i < NKSM && ksm.page[i].pa; i++)
+    ;
+  if(i == NKSM){
+    i = ksm.next;
+    ksm.next = (ksm.next + 1) % NKSM;
+    kfree((void*)ksm.page[i].pa);
+  }
+  makecow(p, mpe->va, pte);
+  kdup((void*)pa);
+  ksm.page[i].hash = h;
+  ksm.page[i].pa = pa;
+}
+
+// A scan of p, every KSMINTERVAL ticks p spends in user space.
+void
+ksm_tick(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int i, n;
+
+  acquire(&ksm.lock);
+  // drop one shared page that only the table still holds.
+  i = ksm.prune;
+  ksm.prune = (ksm.prune + 1) % NKSM;
+  if(ksm.page[i].pa && krefcnt((void*)ksm.page[i].pa) == 1){
+    kfree((void*)ksm.page[i].pa);
+    ksm.page[i].pa = 0;
+  }
+
+  for(n = 0; n < KSMSCAN && n < pmd->mem.n; n++){
+    i = pgindex_next(&pmd->mem, pmd->ksm_hand);
+    if(i < 0 && (i = pgindex_next(&pmd->mem, 0)) < 0)
+      break;
+    pmd->ksm_hand = i + 1;
+    scan(p, MPE(pmd, i));
+  }
+  release(&ksm.lock);
+}
+
+// Fill in st's zero page and merging counters. A shared page
+// mapped n times saves n-1 frames.
+void
+ksm_stat(struct memstat *st)
+{
+  int n;
+
+  acquire(&ksm.lock);
+  st->zeropages = krefcnt(ksm.zero) - 1;
+  st->ksmscanned = ksm.scanned;
+  st->ksmmerged = ksm.merged;
+  st->ksmshared = 0;
+  st->ksmsaved = 0;
+  for(int i = 0; i < NKSM; i++){
+    if(ksm.page[i].pa == 0)
+      continue;
+    st->ksmshared++;
+    if((n = krefcnt((void*)ksm.page[i].pa) - 1) > 1)
+      st->ksmsaved += n - 1;
+  }
+  release(&ksm.lock);
+}
@@ -0,0 +1,6 @@
+// Advice for madvise().
+#define MADV_NORMAL     0  // no special treatment
+#define MADV_RANDOM     1  // random access: no readahead
+#define MADV_SEQUENTIAL 2  // sequential access: read ahead, evict behind
+#define MADV_WILLNEED   3  // needed soon: start reading it in from swap
+#define MADV_DONTNEED   4  // not needed: free it, to refault as untouched
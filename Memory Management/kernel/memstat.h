@@ -0,0 +1,42 @@
+// Kernel memory allocator counters, as reported by getmemstat()
+// and getslabstat().
+
+#define MAXORDER 10   // block orders 0..MAXORDER-1, 4 KB to 2 MB
+
+struct memstat {
+  uint64 npages;          // Pages the allocator manages
+  uint64 nfreepages;      // Pages free
+  uint nfree[MAXORDER];   // Free blocks of 2^order pages
+  uint nalloc[MAXORDER];  // Successful allocations of each order
+  uint nfail[MAXORDER];   // Allocations that found no free block
+  uint nsplit;            // Blocks split to serve a smaller order
+  uint nmerge;            // Buddies merged on free
+
+  // compressed swap pool, see zswap.c
+  uint64 zpoolbytes;      // Bytes of the pool in use
+  uint zpages;            // Swapped-out pages held in the pool
+  uint zstores;           // Pages compressed into the pool
+  uint zrejects;          // Pages that compressed badly or did not fit
+  uint zhits;             // Swap reads served from the pool
+  uint zmisses;           // Swap reads that went to disk
+  uint64 zbytesin;        // Bytes of pages compressed into the pool
+  uint64 zbytesout;       // Bytes they compressed to
+
+  // shared zero page and same-page merging, see ksm.c
+  uint zeropages;         // User pages mapping the zero page
+  uint ksmscanned;        // Pages hashed by the scanner
+  uint ksmmerged;         // Pages it merged into another
+  uint ksmshared;         // Pages it tracks as shared
+  uint ksmsaved;          // Frames those shared pages save
+};
+
+// Counters of one slab cache, as reported by getslabstat().
+struct slabstat {
+  char name[16];
+  uint size;        // Object size in bytes
+  uint perslab;     // Objects in a slab page
+  uint nslabs;      // Slab pages in use
+  uint nalloc;      // Objects allocated
+  uint nfree;       // Objects freed
+  uint nmiss;       // Allocations that had to refill a magazine
+};
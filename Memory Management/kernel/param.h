@@ -6,8 +6,34 @@
 #define NDEV         10  // maximum major device number
 #define ROOTDEV       1  // device number of file system root disk
 #define MAXARG       32  // max exec arguments
+#define NEXECSEG      4  // ELF segments exec loads on demand
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
 #define FSSIZE       2000  // size of file system in blocks
+#define NSWAPPAGES   1024  // size of swap area in pages, after the file system
+#define SWAPCLUSTER     4  // max pages moved by one swap I/O
+#define NSWAPCACHE     32  // pages read ahead from swap, see swap.c
+#define NZSWAPPAGES    64  // size of compressed swap pool, see zswap.c
+#ifndef AGEINTERVAL
+#define AGEINTERVAL     1  // timer ticks between aging passes, see policy_tick()
+#endif
+#ifndef AGESAMPLE
+#define AGESAMPLE      16  // resident pages sampled per aging pass
+#endif
+#ifndef KSMINTERVAL
+#define KSMINTERVAL     0  // timer ticks between same-page scans, 0 for none
+#endif
+#define WSWINDOW        8  // aging passes a used page stays in the working set
+#define WSINTERVAL      8  // aging passes between working-set estimates
+#ifndef RECLAIMLOW
+#define RECLAIMLOW    256  // free pages below which processes are trimmed
+#endif
+#define RECLAIMHIGH (2*RECLAIMLOW) // free pages trimming aims for
+#define RECLAIMBATCH   16  // max pages a process gives up per aging pass
+#define KSMSCAN         8  // resident pages hashed per scan, see ksm.c
+#define NKSM           64  // shared pages the scanner keeps track of
+#define NSHM           16  // shared memory segments in the system
+#define SHMMAXPAGES    64  // max pages in a shared memory segment
+#define NSHMPROC        4  // max segments a process holds
 #define MAXPATH      128   // maximum file path name
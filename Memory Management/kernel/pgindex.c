@@ -0,0 +1,251 @@
+// Page index.
+//
+// A pgindex holds a process's resident or swapped-out page
+// entries, keyed by virtual address. Entries are allocated from
+// pages obtained with kalloc() as the index grows, up to its
+// limit; a bitmap records which ones are in use, and a hash
+// table with chains maps a va to its entry, so that adding,
+// finding and removing a page take constant time no matter how
+// many pages the process has.
+//
+// Every entry type must start with its uint64 va. An index
+// that has never had an entry added owns no memory.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "pgstat.h"
+#include "proc.h"
+#include "defs.h"
+
+#define NBUCKET   512                      // hash chains
+#define LINKSPERPAGE (PGSIZE/sizeof(int))
+
+struct pgindex_meta {
+  int bucket[NBUCKET];            // first entry of each chain, -1 if none
+  uint64 used[PGINDEX_MAX/64];    // bit set if entry is in use
+};
+
+static int
+hash(uint64 va)
+{
+  return (va >> PGSHIFT) % NBUCKET;
+}
+
+static int*
+link(struct pgindex *ix, int i)
+{
+  return &ix->link[i / LINKSPERPAGE][i % LINKSPERPAGE];
+}
+
+static int
+isused(struct pgindex *ix, int i)
+{
+  return (ix->meta->used[i/64] >> (i%64)) & 1;
+}
+
+// Set up an empty index of entries of esz bytes.
+void
+pgindex_init(struct pgindex *ix, int esz, int limit)
+{
+  memset(ix, 0, sizeof(*ix));
+  ix->esz = esz;
+  ix->limit = limit;
+}
+
+// Free the memory of ix, dropping all its entries.
+// It keeps its entry size and limit.
+void
+pgindex_free(struct pgindex *ix)
+{
+  int i;
+
+  for(i = 0; i < PGINDEX_PAGES; i++)
+    if(ix->page[i])
+      kfree(ix->page[i]);
+  for(i = 0; i < PGINDEX_LINKPAGES; i++)
+    if(ix->link[i])
+      kfree(ix->link[i]);
+  if(ix->meta)
+    kfree(ix->meta);
+  pgindex_init(ix, ix->esz, ix->limit);
+}
+
+// Change the number of entries ix may hold.
+int
+pgindex_setlimit(struct pgindex *ix, int limit)
+{
+  if(limit < ix->n || limit < 1 || limit > PGINDEX_MAX)
+    return -1;
+  if(limit > (PGSIZE / ix->esz) * PGINDEX_PAGES)
+    return -1;
+  ix->limit = limit;
+  return 0;
+}
+
+// Return entry i, which must have storage.
+void*
+pgindex_get(struct pgindex *ix, int i)
+{
+  int epp = PGSIZE / ix->esz;
+
+  if(i < 0 || i >= ix->cap)
+    panic("pgindex_get");
+  return ix->page[i / epp] + (i % epp) * ix->esz;
+}
+
+// Add storage for one more page of entries.
+static int
+grow(struct pgindex *ix)
+{
+  int epp = PGSIZE / ix->esz;
+  int p = ix->cap / epp;
+  int ncap = ix->cap + epp;
+
+  if(p >= PGINDEX_PAGES || ix->cap >= PGINDEX_MAX)
+    return -1;
+  if(ncap > PGINDEX_MAX)
+    ncap = PGINDEX_MAX;
+  for(int l = ix->cap / LINKSPERPAGE; l <= (ncap - 1) / LINKSPERPAGE; l++){
+    if(ix->link[l] == 0 && (ix->link[l] = (int*)kalloc()) == 0)
+      return -1;
+  }
+  if((ix->page[p] = kalloc()) == 0)
+    return -1;
+  memset(ix->page[p], 0, PGSIZE);
+  ix->cap = ncap;
+  return 0;
+}
+
+// Return the entry for va, or -1.
+int
+pgindex_find(struct pgindex *ix, uint64 va)
+{
+  if(ix->meta == 0)
+    return -1;
+  for(int i = ix->meta->bucket[hash(va)]; i >= 0; i = *link(ix, i)){
+    if(*(uint64*)pgindex_get(ix, i) == va)
+      return i;
+  }
+  return -1;
+}
+
+// Allocate a zeroed entry for va, which must not be in ix.
+// Returns its number, or -1 if ix is at its limit or out of memory.
+int
+pgindex_add(struct pgindex *ix, uint64 va)
+{
+  int i, h;
+
+  if(ix->n >= ix->limit)
+    return -1;
+  if(ix->meta == 0){
+    if((ix->meta = (struct pgindex_meta*)kalloc()) == 0)
+      return -1;
+    memset(ix->meta, 0, sizeof(*ix->meta));
+    for(h = 0; h < NBUCKET; h++)
+      ix->meta->bucket[h] = -1;
+  }
+
+  // no entry below hint is free; skip full words of the bitmap.
+  for(i = ix->hint; i < ix->cap; i++){
+    if(i % 64 == 0 && ix->meta->used[i/64] == ~0UL){
+      i += 63;
+      continue;
+    }
+    if(!isused(ix, i))
+      break;
+  }
+  if(i >= ix->cap){
+    i = ix->cap;
+    if(grow(ix) < 0)
+      return -1;
+  }
+
+  ix->meta->used[i/64] |= 1UL << (i%64);
+  ix->hint = i + 1;
+  ix->n++;
+  void *e = pgindex_get(ix, i);
+  memset(e, 0, ix->esz);
+  *(uint64*)e = va;
+  h = hash(va);
+  *link(ix, i) = ix->meta->bucket[h];
+  ix->meta->bucket[h] = i;
+  return i;
+}
+
+// Remove entry i from ix.
+void
+pgindex_remove(struct pgindex *ix, int i)
+{
+  void *e = pgindex_get(ix, i);
+  int *pp;
+
+  if(!isused(ix, i))
+    panic("pgindex_remove");
+  for(pp = &ix->meta->bucket[hash(*(uint64*)e)]; *pp != i; pp = link(ix, *pp))
+    if(*pp < 0)
+      panic("pgindex_remove: chain");
+  *pp = *link(ix, i);
+
+  ix->meta->used[i/64] &= ~(1UL << (i%64));
+  if(i < ix->hint)
+    ix->hint = i;
+  ix->n--;
+  memset(e, 0, ix->esz);
+}
+
+// Return the first entry in use at or after i, or -1.
+int
+pgindex_next(struct pgindex *ix, int i)
+{
+  if(ix->meta == 0)
+    return -1;
+  for(; i < ix->cap; i++){
+    if(i % 64 == 0 && ix->meta->used[i/64] == 0){
+      i += 63;
+      continue;
+    }
+    if(isused(ix, i))
+      return i;
+  }
+  return -1;
+}
+
+// Make the empty index dst a copy of src, for fork.
+int
+pgindex_copy(struct pgindex *dst, struct pgindex *src)
+{
+  int i;
+
+  pgindex_init(dst, src->esz, src->limit);
+  if(src->meta == 0)
+    return 0;
+  if((dst->meta = (struct pgindex_meta*)kalloc()) == 0)
+    goto bad;
+  memmove(dst->meta, src->meta, sizeof(*src->meta));
+  for(i = 0; i < PGINDEX_PAGES; i++){
+    if(src->page[i] == 0)
+      continue;
+    if((dst->page[i] = kalloc()) == 0)
+      goto bad;
+    memmove(dst->page[i], src->page[i], PGSIZE);
+  }
+  for(i = 0; i < PGINDEX_LINKPAGES; i++){
+    if(src->link[i] == 0)
+      continue;
+    if((dst->link[i] = (int*)kalloc()) == 0)
+      goto bad;
+    memmove(dst->link[i], src->link[i], PGSIZE);
+  }
+  dst->n = src->n;
+  dst->cap = src->cap;
+  dst->hint = src->hint;
+  return 0;
+
+ bad:
+  pgindex_free(dst);
+  return -1;
+}
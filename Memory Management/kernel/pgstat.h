@@ -0,0 +1,15 @@
+// Paging counters, as reported by getpgstat(), for one
+// process or, with pid 0, summed over the whole system.
+struct pgstat {
+  uint faults;     // Page faults handled
+  uint majfaults;  // Faults that had to wait for the disk
+  uint minfaults;  // Faults served from memory: COW, lazy, swap cache
+  uint swapins;    // Pages read back from the swap area
+  uint swapouts;   // Pages evicted to the swap area
+  uint64 bytesout; // Bytes written to the swap area
+  uint rahits;     // Swap-ins served by pages read ahead
+  uint ramisses;   // Swap-ins that had to wait for the disk
+  uint reclaimed;  // Pages evicted by global reclaim
+  uint resident;   // Pages in memory, when read
+  uint wss;        // Working-set estimate, when read
+};
@@ -3,7 +3,9 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "pgstat.h"
 #include "proc.h"
+#include "swappolicy.h"
 #include "defs.h"
 
 
@@ -13,6 +15,8 @@ struct proc proc[NPROC];
 
 struct proc *initproc;
 
+struct pgstat pgtotal;  // paging counters of all processes
+
 int nextpid = 1;
 struct spinlock pid_lock;
 
@@ -125,6 +129,10 @@ allocproc(void)
 found:
   p->pid = allocpid();
   p->state = USED;
+  memset(&p->pgstat, 0, sizeof(p->pgstat));
+  p->swap_policy = SWAP_DEFAULT;
+  pgindex_init(&p->paging_metadata.mem, sizeof(struct memory_page_entry), MAX_PSYC_PAGES);
+  pgindex_init(&p->paging_metadata.swap, sizeof(struct swap_file_entry), MAX_TOTAL_PAGES-MAX_PSYC_PAGES);
 
   // Allocate a trapframe page.
   if((p->trapframe = (struct trapframe *)kalloc()) == 0){
@@ -160,8 +168,10 @@ freeproc(struct proc *p)
   if(p->trapframe)
     kfree((void*)p->trapframe);
   p->trapframe = 0;
-  if(p->pagetable)
+  if(p->pagetable){
+    shmdetachall(p, p->pagetable);
     proc_freepagetable(p->pagetable, p->sz);
+  }
   p->pagetable = 0;
   p->sz = 0;
   p->pid = 0;
@@ -174,25 +184,16 @@ freeproc(struct proc *p)
 
   //ass3 - reset paging metadata
   #ifndef NONE
-  if(p->swapFile != 0){
-    removeSwapFile(p);
-  }
-  p->swapFile = 0;
-  p->paging_metadata.num_in_memory= 0;
-  p->paging_metadata.order_counter= 0;
-  p->paging_metadata.num_in_swap= 0;
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    p->paging_metadata.memory_page_entries[i].present = 0;
-    p->paging_metadata.memory_page_entries[i].va = 0;
-    p->paging_metadata.memory_page_entries[i].age = 0;
-    p->paging_metadata.memory_page_entries[i].offset = 0;
-    p->paging_metadata.memory_page_entries[i].order = 0;
-  }
-  for(int i=0; i< MAX_TOTAL_PAGES-MAX_PSYC_PAGES; i++){
-    p->paging_metadata.swap_file_entries[i].present = 0;
-    p->paging_metadata.swap_file_entries[i].va = 0;
-    p->paging_metadata.swap_file_entries[i].offset = 0;
-  }
+  pgindex_free(&p->paging_metadata.mem);
+  pgindex_free(&p->paging_metadata.swap);
+  policy_reset(p);
+  p->paging_metadata.ra_window= 0;
+  p->paging_metadata.ra_last= 0;
+  p->paging_metadata.nmadv = 0;
+  reclaim_setcold(p, 0);
+  p->paging_metadata.wss = 0;
+  p->paging_metadata.agetick = 0;
+  p->paging_metadata.ksmtick = 0;
   #endif
 }
 
@@ -279,6 +280,34 @@ userinit(void)
   release(&p->lock);
 }
 
+// A kernel thread's first scheduling by scheduler()
+// will swtch to kthreadret.
+static void
+kthreadret(void)
+{
+  // Still holding p->lock from scheduler.
+  release(&myproc()->lock);
+
+  myproc()->kfn();
+  panic("kthreadret");
+}
+
+// Start a kernel thread that runs fn(), which must not return.
+// It has no user memory, no parent and is never waited for.
+void
+kthread_create(void (*fn)(void), char *name)
+{
+  struct proc *p;
+
+  if((p = allocproc()) == 0)
+    panic("kthread_create");
+  p->kfn = fn;
+  p->context.ra = (uint64)kthreadret;
+  safestrcpy(p->name, name, sizeof(p->name));
+  p->state = RUNNABLE;
+  release(&p->lock);
+}
+
 // Grow or shrink user memory by n bytes.
 // Return 0 on success, -1 on failure.
 int
@@ -289,9 +318,11 @@ growproc(int n)
 
   sz = p->sz;
   if(n > 0){
-    if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
+    // only reserve the address space; usertrap() fills
+    // each page in on first touch (see lazy_alloc()).
+    if(sz + n >= SHMBASE || sz + n < sz)
       return -1;
-    }
+    sz += n;
   } else if(n < 0){
     sz = uvmdealloc(p->pagetable, sz, sz + n);
   }
@@ -321,6 +352,33 @@ fork(void)
     return -1;
   }
   np->sz = p->sz;
+  if(shmfork(p, np) < 0){
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+
+  #ifndef NONE
+  //task2
+  if(p->pid >2 && !(p->name[0]=='s' && p->name[1]=='h' && p->name[3]=='\000')){
+    struct paging_metadata *pmd = &p->paging_metadata;
+    struct paging_metadata *npmd = &np->paging_metadata;
+    // policy state is copied as is, the indexes entry by entry.
+    *npmd = *pmd;
+    npmd->cold = 0;   // counted once ws_update() runs for np
+    pgindex_init(&npmd->mem, pmd->mem.esz, pmd->mem.limit);
+    pgindex_init(&npmd->swap, pmd->swap.esz, pmd->swap.limit);
+    if(pgindex_copy(&npmd->mem, &pmd->mem) < 0 ||
+       pgindex_copy(&npmd->swap, &pmd->swap) < 0){
+      freeproc(np);
+      release(&np->lock);
+      return -1;
+    }
+    // share the parent's swapped-out pages instead of
+    // copying them; see swap_dup().
+    dup_swap_entries(np);
+  }
+  #endif
 
   // copy saved user registers.
   *(np->trapframe) = *(p->trapframe);
@@ -335,30 +393,21 @@ fork(void)
     if(p->ofile[i])
       np->ofile[i] = filedup(p->ofile[i]);
   np->cwd = idup(p->cwd);
+  if(p->exe){
+    idenywrite(p->exe);   // can't fail, p holds it
+    np->exe = idup(p->exe);
+  }
+  np->nseg = p->nseg;
+  memmove(np->seg, p->seg, sizeof(p->seg));
 
   safestrcpy(np->name, p->name, sizeof(p->name));
 
+  np->swap_policy = p->swap_policy;
+
   pid = np->pid;
 
   release(&np->lock);
 
-  #ifndef NONE
-  //task2
-  if(p->pid >2 && p->swapFile!=0 && !(p->name[0]=='s' && p->name[1]=='h' && p->name[3]=='\000')){
-    if(createSwapFile(np) == -1){ 
-      printf("fork: createSwapFile failed\n");
-      freeproc(np);
-      return 0;
-    }
-    np->paging_metadata  = p->paging_metadata;
-    if(copy_swap_file(p, np)==-1){
-      printf("fork: copy_swap_file failed\n");
-      freeproc(np);
-      return 0;
-    }
-  }
-  #endif
-
 
   acquire(&wait_lock);
   np->parent = p;
@@ -407,15 +456,21 @@ exit(int status)
   }
 
   //task2
-  if(p->swapFile != 0){ 
-    removeSwapFile(p);
-    p->swapFile = 0;
-  }
+  #ifndef NONE
+  free_swap_entries(&p->paging_metadata.swap);
+  free_clean_pages(&p->paging_metadata.mem);
+  #endif
 
   begin_op();
   iput(p->cwd);
+  if(p->exe){
+    iallowwrite(p->exe);
+    iput(p->exe);
+  }
   end_op();
   p->cwd = 0;
+  p->exe = 0;
+  p->nseg = 0;
 
   acquire(&wait_lock);
 
@@ -446,6 +501,8 @@ wait(uint64 addr)
   int havekids, pid;
   struct proc *p = myproc();
 
+  if(addr != 0)
+    uvmprefault(addr, sizeof(int));
   acquire(&wait_lock);
 
   for(;;){
@@ -486,6 +543,42 @@ wait(uint64 addr)
   }
 }
 
+// Copy the paging counters of process pid out to addr
+// in the caller's address space. Resident and working-set
+// sizes are read now; for pid 0 they are summed over all
+// processes.
+int
+getpgstat(int pid, uint64 addr)
+{
+  struct proc *p;
+  struct pgstat st;
+
+  if(pid == 0){
+    st = pgtotal;
+    for(p = proc; p < &proc[NPROC]; p++){
+      acquire(&p->lock);
+      if(p->state != UNUSED){
+        st.resident += p->paging_metadata.mem.n;
+        st.wss += p->paging_metadata.wss;
+      }
+      release(&p->lock);
+    }
+    return copyout(myproc()->pagetable, addr, (char*)&st, sizeof(st));
+  }
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      st = p->pgstat;
+      st.resident = p->paging_metadata.mem.n;
+      st.wss = p->paging_metadata.wss;
+      release(&p->lock);
+      return copyout(myproc()->pagetable, addr, (char*)&st, sizeof(st));
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
 // Scheduler never returns.  It loops, doing:
@@ -514,10 +607,6 @@ scheduler(void)
         c->proc = p;
         swtch(&c->context, &p->context);
 
-        #if NFUA || LAPA
-        update_age(p);
-        #endif
-
         // Process is done running for now.
         // It should have changed its p->state before coming back.
         c->proc = 0;
@@ -87,20 +87,89 @@ struct memory_page_entry{
   int present;
   uint age;
   int order;
+  int cleaned;        // a copy was queued to pageoutd, see preclean()
+  int slot;           // swap slot holding that copy
+  int list;           // ARC: 1 if seen once, 2 if seen again
+  uint aged;          // age_clock when the page was last sampled
+  uint ksmhash;       // contents' hash at the last same-page scan
 };
 
 struct swap_file_entry{
   uint64 va;
-  uint64 offset;
+  uint64 offset;      // swap slot holding the page, see swap.c
   int present;
 };
 
+// Entries of a process's pages keyed by va; see pgindex.c.
+#define PGINDEX_MAX       4096  // max entries in one index
+#define PGINDEX_PAGES       64  // max pages of entries
+#define PGINDEX_LINKPAGES (PGINDEX_MAX/(PGSIZE/sizeof(int)))
+
+struct pgindex {
+  int esz;            // size of an entry
+  int limit;          // max entries in use
+  int n;              // entries in use
+  int cap;            // entries with storage
+  int hint;           // no entry below this is free
+  char *page[PGINDEX_PAGES];       // entry storage
+  int *link[PGINDEX_LINKPAGES];    // next entry in each hash chain
+  struct pgindex_meta *meta;       // hash heads and in-use bitmap
+};
+
+#define ARC_NGHOST 64
+#define NMADV 4
+
+// A shared memory segment a process holds.
+struct shmmap{
+  int id;
+  uint64 va;          // where it is attached, or 0
+};
+
+// A range of addresses given MADV_RANDOM or MADV_SEQUENTIAL.
+struct madvrange{
+  uint64 start;
+  uint64 end;
+  int advice;
+  uint64 last;        // last page faulted in, for evict-behind
+};
+
 struct paging_metadata{
-  int num_in_memory;
   int order_counter;
-  int num_in_swap;
-  struct memory_page_entry memory_page_entries[MAX_PSYC_PAGES];
-  struct swap_file_entry swap_file_entries[MAX_TOTAL_PAGES-MAX_PSYC_PAGES];
+  int ra_window;      // pages to read ahead on swap-in, adapted to hits
+  uint64 ra_last;     // va of the last swap-in
+  int clock_hand;     // CLOCK: next resident entry to look at
+  uint age_clock;     // aging passes so far
+  int agetick;        // user timer ticks since the last aging pass
+  int age_hand;       // next resident entry to sample
+  int ksm_hand;       // next resident entry to scan for merging
+  int ksmtick;        // user timer ticks since the last scan
+  int arc_target;     // ARC: frames T1 should get
+  int nghost[2];      // ARC: lengths of B1 and B2
+  uint64 ghost[2][ARC_NGHOST]; // ARC: va of pages evicted from T1, T2
+  int wss;            // working-set estimate, see ws_update()
+  int cold;           // resident pages outside it
+  int nmadv;
+  struct madvrange madv[NMADV]; // see madvise()
+  struct pgindex mem;   // resident pages, struct memory_page_entry
+  struct pgindex swap;  // swapped-out pages, struct swap_file_entry
+};
+
+#define MPE(pmd, i) ((struct memory_page_entry*)pgindex_get(&(pmd)->mem, (i)))
+#define SFE(pmd, i) ((struct swap_file_entry*)pgindex_get(&(pmd)->swap, (i)))
+
+// Loop over the numbers of the entries in use in index ix.
+#define for_each_entry(i, ix) \
+  for((i) = pgindex_next((ix), 0); (i) >= 0; (i) = pgindex_next((ix), (i)+1))
+
+// An ELF segment of the running program that exec mapped
+// without loading; see lazy_alloc(). The file can't be opened
+// for writing while it runs; see idenywrite().
+struct execseg {
+  uint64 va;          // page-aligned start
+  uint64 filesz;      // bytes read from the file, the rest are zero
+  uint64 memsz;
+  uint off;           // file offset of va
+  int perm;           // PTE_X and PTE_W as in the ELF flags
 };
 
 // Per-process state
@@ -125,9 +194,24 @@ struct proc {
   struct context context;      // swtch() here to run process
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
+  struct inode *exe;           // Program file, backing seg[]
+  int nseg;
+  struct execseg seg[NEXECSEG]; // Segments not loaded by exec
+  int nshm;
+  struct shmmap shm[NSHMPROC]; // Shared memory held, see shm.c
   char name[16];               // Process name (debugging)
+  void (*kfn)(void);           // Body of a kernel thread, see kthread_create()
+  int swap_policy;             // Page replacement policy, see swappolicy.c
 
-  struct file *swapFile;
   struct paging_metadata paging_metadata;
+  struct pgstat pgstat;        // Paging counters, see getpgstat()
 };
 
+extern struct pgstat pgtotal;
+
+// Count n paging events of kind f for p and for the system.
+#define PGSTAT_ADD(p, f, n) do { \
+  (p)->pgstat.f += (n); \
+  __sync_fetch_and_add(&pgtotal.f, (n)); \
+} while(0)
+
@@ -0,0 +1,250 @@
+// Shared memory segments.
+//
+// shmget() finds or creates a segment by key: up to SHMMAXPAGES
+// zeroed pages, held in a table of NSHM. shmat() maps all of a
+// segment's pages, read/write, at an address the process picks
+// at or above SHMBASE, out of the heap's way, and shmdt() unmaps
+// them. Several processes, or one process at several addresses,
+// then see the same physical pages.
+//
+// A process holds a segment from the time shmget() returns its
+// id, or it attaches one, until it detaches it or exits. An id
+// it got but has not attached yet is kept in p->shm[] with va 0,
+// and the next shmat() of it uses that entry up. A segment goes
+// away, and its pages with it, when its last holder lets go, so
+// an id stays good for as long as any process holds it, and a
+// segment that is created and never attached goes when its
+// creator exits. fork gives the child everything the parent
+// holds, at the same places; exec and exit let go of everything.
+//
+// Pages are reference counted like copy-on-write ones: the table
+// holds one reference to each, and every attachment another.
+// Shared pages are never in a process's resident set, so the
+// paging code neither counts nor evicts them, and uvmcopy() never
+// sees them, since they lie above p->sz.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "pgstat.h"
+#include "proc.h"
+#include "defs.h"
+
+struct {
+  struct spinlock lock;
+  struct {
+    int key;
+    int npages;          // 0 if unused
+    int nhold;           // entries in p->shm[] for it, in all procs
+    void *pa[SHMMAXPAGES];
+  } seg[NSHM];
+} shm;
+
+void
+shminit(void)
+{
+  initlock(&shm.lock, "shm");
+}
+
+// The index of p's unattached entry for id, or -1.
+// Caller holds shm.lock.
+static int
+unattached(struct proc *p, int id)
+{
+  for(int k = 0; k < p->nshm; k++)
+    if(p->shm[k].id == id && p->shm[k].va == 0)
+      return k;
+  return -1;
+}
+
+// Add an entry for id at va, 0 if not attached, to p's.
+// Caller holds shm.lock.
+static void
+hold(struct proc *p, int id, uint64 va)
+{
+  p->shm[p->nshm].id = id;
+  p->shm[p->nshm].va = va;
+  p->nshm++;
+  shm.seg[id].nhold++;
+}
+
+// Return the id of the segment with key, first creating it with
+// npages zeroed pages if there is none, and hold it for the
+// current process. Returns -1 if there is no room, or the
+// segment has fewer than npages pages.
+int
+shmget(int key, int npages)
+{
+  struct proc *p = myproc();
+  int i, j, id = -1;
+
+  if(npages < 1 || npages > SHMMAXPAGES)
+    return -1;
+  acquire(&shm.lock);
+  for(i = 0; i < NSHM; i++){
+    if(shm.seg[i].npages && shm.seg[i].key == key){
+      id = shm.seg[i].npages >= npages ? i : -1;
+      if(id >= 0 && unattached(p, id) < 0){
+        if(p->nshm == NSHMPROC)
+          id = -1;
+        else
+          hold(p, id, 0);
+      }
+      release(&shm.lock);
+      return id;
+    }
+    if(shm.seg[i].npages == 0 && id < 0)
+      id = i;
+  }
+  if(id < 0 || p->nshm == NSHMPROC){
+    release(&shm.lock);
+    return -1;
+  }
+  for(j = 0; j < npages; j++){
+    if((shm.seg[id].pa[j] = kalloc()) == 0){
+      while(--j >= 0)
+        kfree(shm.seg[id].pa[j]);
+      release(&shm.lock);
+      return -1;
+    }
+    memset(shm.seg[id].pa[j], 0, PGSIZE);
+  }
+  shm.seg[id].key = key;
+  shm.seg[id].npages = npages;
+  shm.seg[id].nhold = 0;
+  hold(p, id, 0);
+  release(&shm.lock);
+  return id;
+}
+
+// Map segment id into pagetable at va, for p, using up p's
+// unattached entry for id if it has one. Caller holds shm.lock.
+static int
+attach(struct proc *p, pagetable_t pagetable, int id, uint64 va)
+{
+  int n = shm.seg[id].npages;
+  int j, k;
+
+  for(j = 0; j < n; j++){
+    if(mappages(pagetable, va + j*PGSIZE, PGSIZE,
+                (uint64)shm.seg[id].pa[j], PTE_R|PTE_W|PTE_U) != 0){
+      uvmunmap(pagetable, va, j, 0);
+      return -1;
+    }
+  }
+  for(j = 0; j < n; j++)
+    kdup(shm.seg[id].pa[j]);
+  if((k = unattached(p, id)) >= 0)
+    p->shm[k].va = va;
+  else
+    hold(p, id, va);
+  return 0;
+}
+
+// Drop p's k'th entry, unmapping it from pagetable if it is
+// attached. Caller holds shm.lock.
+static void
+detach(struct proc *p, pagetable_t pagetable, int k)
+{
+  int id = p->shm[k].id;
+  int n = shm.seg[id].npages;
+  int j;
+
+  if(p->shm[k].va){
+    uvmunmap(pagetable, p->shm[k].va, n, 0);
+    for(j = 0; j < n; j++)
+      kfree(shm.seg[id].pa[j]);
+  }
+  if(--shm.seg[id].nhold == 0){
+    for(j = 0; j < n; j++)
+      kfree(shm.seg[id].pa[j]);
+    shm.seg[id].npages = 0;
+  }
+  p->shm[k] = p->shm[--p->nshm];
+}
+
+// Attach segment id to the current process at va, which must
+// be page-aligned, at or above SHMBASE, and clear of its other
+// segments. Returns va, or -1.
+uint64
+shmat(int id, uint64 va)
+{
+  struct proc *p = myproc();
+  uint64 end, a;
+  int k;
+
+  if(id < 0 || id >= NSHM || va % PGSIZE || va < SHMBASE)
+    return -1;
+  acquire(&shm.lock);
+  if(shm.seg[id].npages == 0)
+    goto bad;
+  if(p->nshm == NSHMPROC && unattached(p, id) < 0)
+    goto bad;
+  end = va + shm.seg[id].npages * PGSIZE;
+  if(end > TRAPFRAME)
+    goto bad;
+  for(k = 0; k < p->nshm; k++){
+    a = p->shm[k].va;
+    if(a && va < a + shm.seg[p->shm[k].id].npages * PGSIZE && a < end)
+      goto bad;
+  }
+  if(attach(p, p->pagetable, id, va) < 0)
+    goto bad;
+  release(&shm.lock);
+  return va;
+
+ bad:
+  release(&shm.lock);
+  return -1;
+}
+
+// Detach the segment the current process attached at va.
+int
+shmdt(uint64 va)
+{
+  struct proc *p = myproc();
+
+  acquire(&shm.lock);
+  for(int k = 0; k < p->nshm; k++){
+    if(p->shm[k].va && p->shm[k].va == va){
+      detach(p, p->pagetable, k);
+      release(&shm.lock);
+      return 0;
+    }
+  }
+  release(&shm.lock);
+  return -1;
+}
+
+// Let go of all of p's segments, detaching them from pagetable,
+// for exec and freeproc.
+void
+shmdetachall(struct proc *p, pagetable_t pagetable)
+{
+  acquire(&shm.lock);
+  while(p->nshm > 0)
+    detach(p, pagetable, p->nshm - 1);
+  release(&shm.lock);
+}
+
+// Give the child np all of p's segments, attached at the same
+// addresses.
+int
+shmfork(struct proc *p, struct proc *np)
+{
+  acquire(&shm.lock);
+  for(int k = 0; k < p->nshm; k++){
+    if(p->shm[k].va == 0){
+      hold(np, p->shm[k].id, 0);
+      continue;
+    }
+    if(attach(np, np->pagetable, p->shm[k].id, p->shm[k].va) < 0){
+      release(&shm.lock);
+      return -1;
+    }
+  }
+  release(&shm.lock);
+  return 0;
+}
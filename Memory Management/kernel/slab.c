@@ -0,0 +1,230 @@
+// Slab allocator for small fixed-size kernel objects.
+//
+// A cache hands out objects of one size, carved out of slabs:
+// pages from kalloc(), each starting with a struct slab and
+// holding as many objects as fit after it. The free objects of a
+// slab are chained through their first word. A slab that has
+// free objects is on its cache's partial list; one that becomes
+// entirely free goes back to kalloc().
+//
+// In front of the slabs each CPU has a magazine, a small stack
+// of free objects, so that most allocations and frees take no
+// lock and get an object that was freed recently, and is likely
+// still in the CPU's cache. When a magazine is empty or full,
+// half of MAGSIZE objects move between it and the slabs at once.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "defs.h"
+#include "memstat.h"
+
+#define NKMEMCACHE 16   // caches in the system
+#define MAGSIZE     8   // objects in a per-CPU magazine
+
+struct slab {
+  struct slab *next;     // on the partial list
+  struct slab *prev;
+  void *freelist;
+  int inuse;             // objects handed out or in magazines
+};
+
+struct kmem_cache {
+  struct spinlock lock;
+  char name[16];
+  int size;
+  int perslab;
+  struct slab partial;   // list head, circular
+  struct {
+    int n;
+    void *obj[MAGSIZE];
+  } mag[NCPU];
+  uint nslabs;
+  uint nalloc;
+  uint nfree;
+  uint nmiss;            // allocations the magazine could not serve
+};
+
+struct {
+  struct spinlock lock;
+  int n;
+  struct kmem_cache cache[NKMEMCACHE];
+} kmemcaches;
+
+void
+slabinit(void)
+{
+  initlock(&kmemcaches.lock, "kmemcaches");
+}
+
+// Create a cache of objects of size bytes, which must fit in a
+// slab. Panics if there are too many caches, since caches are
+// only created at boot.
+struct kmem_cache*
+kmem_cache_create(char *name, int size)
+{
+  struct kmem_cache *c;
+
+  size = (size + 7) & ~7;
+  if(size < sizeof(void*) || size > PGSIZE - sizeof(struct slab))
+    panic("kmem_cache_create: size");
+  acquire(&kmemcaches.lock);
+  if(kmemcaches.n == NKMEMCACHE)
+    panic("kmem_cache_create: too many");
+  c = &kmemcaches.cache[kmemcaches.n++];
+  release(&kmemcaches.lock);
+
+  initlock(&c->lock, name);
+  safestrcpy(c->name, name, sizeof(c->name));
+  c->size = size;
+  c->perslab = (PGSIZE - sizeof(struct slab)) / size;
+  c->partial.next = c->partial.prev = &c->partial;
+  return c;
+}
+
+// Get a page for a new slab of c and put it on the partial
+// list. Caller holds c->lock.
+static struct slab*
+slab_grow(struct kmem_cache *c)
+{
+  struct slab *s;
+  char *o;
+
+  if((s = kalloc()) == 0)
+    return 0;
+  s->freelist = 0;
+  s->inuse = 0;
+  for(int i = c->perslab - 1; i >= 0; i--){
+    o = (char*)(s + 1) + i * c->size;
+    *(void**)o = s->freelist;
+    s->freelist = o;
+  }
+  s->next = c->partial.next;
+  s->prev = &c->partial;
+  s->next->prev = s;
+  c->partial.next = s;
+  c->nslabs++;
+  return s;
+}
+
+static void
+slab_unlink(struct slab *s)
+{
+  s->prev->next = s->next;
+  s->next->prev = s->prev;
+  s->next = s->prev = 0;
+}
+
+// Take an object from the slabs of c, or return 0.
+// Caller holds c->lock.
+static void*
+slab_take(struct kmem_cache *c)
+{
+  struct slab *s = c->partial.next;
+  void *o;
+
+  if(s == &c->partial && (s = slab_grow(c)) == 0)
+    return 0;
+  o = s->freelist;
+  s->freelist = *(void**)o;
+  s->inuse++;
+  if(s->freelist == 0)
+    slab_unlink(s);
+  return o;
+}
+
+// Give object o back to its slab. Caller holds c->lock.
+static void
+slab_put(struct kmem_cache *c, void *o)
+{
+  struct slab *s = (struct slab*)PGROUNDDOWN((uint64)o);
+
+  if(s->freelist == 0){
+    // it was full; it has room again.
+    s->next = c->partial.next;
+    s->prev = &c->partial;
+    s->next->prev = s;
+    c->partial.next = s;
+  }
+  *(void**)o = s->freelist;
+  s->freelist = o;
+  if(--s->inuse == 0){
+    slab_unlink(s);
+    c->nslabs--;
+    kfree(s);
+  }
+}
+
+// Allocate an object from c. Returns 0 if out of memory.
+void*
+kmem_cache_alloc(struct kmem_cache *c)
+{
+  void *o = 0;
+  int id;
+
+  push_off();
+  id = cpuid();
+  if(c->mag[id].n == 0){
+    acquire(&c->lock);
+    c->nmiss++;
+    while(c->mag[id].n < MAGSIZE/2 && (o = slab_take(c)) != 0)
+      c->mag[id].obj[c->mag[id].n++] = o;
+    release(&c->lock);
+  }
+  o = 0;
+  if(c->mag[id].n > 0){
+    o = c->mag[id].obj[--c->mag[id].n];
+    __sync_fetch_and_add(&c->nalloc, 1);
+  }
+  pop_off();
+  return o;
+}
+
+// Free an object allocated from c.
+void
+kmem_cache_free(struct kmem_cache *c, void *o)
+{
+  int id;
+
+  push_off();
+  id = cpuid();
+  if(c->mag[id].n == MAGSIZE){
+    acquire(&c->lock);
+    while(c->mag[id].n > MAGSIZE/2)
+      slab_put(c, c->mag[id].obj[--c->mag[id].n]);
+    release(&c->lock);
+  }
+  c->mag[id].obj[c->mag[id].n++] = o;
+  __sync_fetch_and_add(&c->nfree, 1);
+  pop_off();
+}
+
+// Copy the counters of the i'th cache out to addr in the
+// caller's address space. Returns -1 if there is no such cache.
+int
+getslabstat(int i, uint64 addr)
+{
+  struct kmem_cache *c;
+  struct slabstat st;
+
+  acquire(&kmemcaches.lock);
+  if(i < 0 || i >= kmemcaches.n){
+    release(&kmemcaches.lock);
+    return -1;
+  }
+  c = &kmemcaches.cache[i];
+  release(&kmemcaches.lock);
+
+  acquire(&c->lock);
+  safestrcpy(st.name, c->name, sizeof(st.name));
+  st.size = c->size;
+  st.perslab = c->perslab;
+  st.nslabs = c->nslabs;
+  st.nalloc = c->nalloc;
+  st.nfree = c->nfree;
+  st.nmiss = c->nmiss;
+  release(&c->lock);
+  return either_copyout(1, addr, &st, sizeof(st));
+}
@@ -6,6 +6,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "spinlock.h"
+#include "pgstat.h"
 #include "proc.h"
 #include "sleeplock.h"
 
@@ -0,0 +1,328 @@
+// Swap area.
+//
+// mkfs reserves sb.nswap pages of disk after the file system,
+// starting at block sb.swapstart. The area is divided into
+// page-sized slots; a bitmap records which slots are in use.
+//
+// Each slot has a reference count, so that a parent and the
+// children it forks can share a swapped-out page. A slot goes
+// back to the bitmap when its last reference is dropped.
+//
+// swap_alloc() and swap_free() go through a small per-CPU cache
+// of slots, so that most calls do not take swap.lock. Pages move
+// to and from disk with a single virtio request for up to
+// SWAPCLUSTER contiguous slots, bypassing the buffer cache and
+// the log; swap_alloc_cluster() finds such runs for pageoutd.
+//
+// swap_readahead() reads pages into the swap cache, a small
+// table of frames indexed by slot, ahead of the faults that
+// need them. swap_cache_take() hands such a frame over to the
+// faulting process. A slot's contents never change while it is
+// allocated, so a cached page only goes stale when the slot is
+// freed, and swap_free() drops it then.
+//
+// Below all of this, swap_write() offers each page to the
+// compressed pool in zswap.c first, and swap_read() looks there
+// before going to disk.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "fs.h"
+#include "defs.h"
+
+#define SWAP_BATCH 16   // slots moved between a CPU cache and the bitmap
+
+extern struct superblock sb;
+
+struct {
+  struct spinlock lock;
+  uchar map[NSWAPPAGES/8];   // bit set if slot is allocated
+  int ref[NSWAPPAGES];       // updated with atomics, no lock
+} swap;
+
+struct {
+  int n;
+  int slot[SWAP_BATCH];
+} slotcache[NCPU];
+
+struct {
+  struct spinlock lock;
+  int next;                  // round-robin replacement
+  struct {
+    int slot;                // -1 if unused
+    void *pa;
+  } page[NSWAPCACHE];
+} swapcache;
+
+void
+swapinit(void)
+{
+  initlock(&swap.lock, "swap");
+  initlock(&swapcache.lock, "swapcache");
+  for(int i = 0; i < NSWAPCACHE; i++)
+    swapcache.page[i].slot = -1;
+}
+
+// Move up to SWAP_BATCH free slots from the bitmap to
+// this CPU's cache. Interrupts must be off.
+static void
+refill(int id)
+{
+  int i;
+
+  acquire(&swap.lock);
+  for(i = 0; i < NSWAPPAGES && slotcache[id].n < SWAP_BATCH; i++){
+    if((swap.map[i/8] & (1 << (i%8))) == 0){
+      swap.map[i/8] |= 1 << (i%8);
+      slotcache[id].slot[slotcache[id].n++] = i;
+    }
+  }
+  release(&swap.lock);
+}
+
+// Give half of this CPU's cache back to the bitmap.
+// Interrupts must be off.
+static void
+drain(int id)
+{
+  int i;
+
+  acquire(&swap.lock);
+  while(slotcache[id].n > SWAP_BATCH/2){
+    i = slotcache[id].slot[--slotcache[id].n];
+    swap.map[i/8] &= ~(1 << (i%8));
+  }
+  release(&swap.lock);
+}
+
+// Allocate a swap slot with one reference.
+// Returns -1 if the swap area is full.
+int
+swap_alloc(void)
+{
+  int id, slot = -1;
+
+  push_off();
+  id = cpuid();
+  if(slotcache[id].n == 0)
+    refill(id);
+  if(slotcache[id].n > 0)
+    slot = slotcache[id].slot[--slotcache[id].n];
+  pop_off();
+
+  if(slot >= 0)
+    swap.ref[slot] = 1;
+  return slot;
+}
+
+// Allocate n contiguous swap slots with one reference each,
+// straight from the bitmap. Returns the first, or -1 if there
+// is no such run.
+int
+swap_alloc_cluster(int n)
+{
+  int i, j;
+
+  acquire(&swap.lock);
+  for(i = 0; i + n <= NSWAPPAGES; i++){
+    for(j = 0; j < n; j++){
+      if(swap.map[(i+j)/8] & (1 << ((i+j)%8)))
+        break;
+    }
+    if(j == n){
+      for(j = i; j < i + n; j++){
+        swap.map[j/8] |= 1 << (j%8);
+        swap.ref[j] = 1;
+      }
+      release(&swap.lock);
+      return i;
+    }
+    i += j;
+  }
+  release(&swap.lock);
+  return -1;
+}
+
+// Take another reference to slot.
+void
+swap_dup(int slot)
+{
+  if(slot < 0 || slot >= NSWAPPAGES || swap.ref[slot] < 1)
+    panic("swap_dup");
+  __sync_fetch_and_add(&swap.ref[slot], 1);
+}
+
+// Drop a reference to slot, freeing it with the last one.
+void
+swap_free(int slot)
+{
+  int id;
+
+  if(slot < 0 || slot >= NSWAPPAGES)
+    panic("swap_free");
+  if(__sync_sub_and_fetch(&swap.ref[slot], 1) > 0)
+    return;
+
+  acquire(&swapcache.lock);
+  for(int i = 0; i < NSWAPCACHE; i++){
+    if(swapcache.page[i].slot == slot){
+      kfree(swapcache.page[i].pa);
+      swapcache.page[i].slot = -1;
+    }
+  }
+  release(&swapcache.lock);
+  zswap_drop(slot);
+
+  push_off();
+  id = cpuid();
+  if(slotcache[id].n == SWAP_BATCH)
+    drain(id);
+  slotcache[id].slot[slotcache[id].n++] = slot;
+  pop_off();
+}
+
+static uint64
+slot2sector(int slot)
+{
+  return (sb.swapstart + (uint64)slot * (PGSIZE / BSIZE)) * (BSIZE / 512);
+}
+
+// Read slot into the physical page pa.
+void
+swap_read(int slot, void *pa)
+{
+  if(zswap_load(slot, pa) == 0)
+    return;
+  virtio_disk_rwraw(slot2sector(slot), &pa, 1, PGSIZE, 0);
+}
+
+// Write the physical page pa to slot.
+void
+swap_write(int slot, void *pa)
+{
+  if(zswap_store(slot, pa) == 0)
+    return;
+  virtio_disk_rwraw(slot2sector(slot), &pa, 1, PGSIZE, 1);
+}
+
+// Write the n pages pa[] to slots slot..slot+n-1 at once.
+// If any of them does not go into the compressed pool, all
+// of them go to disk, in one request.
+void
+swap_writev(int slot, void **pa, int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++){
+    if(zswap_store(slot + i, pa[i]) < 0)
+      break;
+  }
+  if(i == n)
+    return;
+  while(--i >= 0)
+    zswap_unstore(slot + i);
+  virtio_disk_rwraw(slot2sector(slot), pa, n, PGSIZE, 1);
+}
+
+// If slot is in the swap cache, remove it and return its
+// frame, which now belongs to the caller. Otherwise return 0.
+void*
+swap_cache_take(int slot)
+{
+  void *pa = 0;
+
+  acquire(&swapcache.lock);
+  for(int i = 0; i < NSWAPCACHE; i++){
+    if(swapcache.page[i].slot == slot){
+      pa = swapcache.page[i].pa;
+      swapcache.page[i].slot = -1;
+      break;
+    }
+  }
+  release(&swapcache.lock);
+  return pa;
+}
+
+static int
+swap_cached(int slot)
+{
+  int r = 0;
+
+  acquire(&swapcache.lock);
+  for(int i = 0; i < NSWAPCACHE; i++){
+    if(swapcache.page[i].slot == slot)
+      r = 1;
+  }
+  release(&swapcache.lock);
+  return r;
+}
+
+static void
+swap_cache_put(int slot, void *pa)
+{
+  int i;
+
+  acquire(&swapcache.lock);
+  for(i = 0; i < NSWAPCACHE; i++){
+    if(swapcache.page[i].slot == slot){
+      // someone else read it ahead meanwhile.
+      release(&swapcache.lock);
+      kfree(pa);
+      return;
+    }
+  }
+  for(i = 0; i < NSWAPCACHE; i++){
+    if(swapcache.page[i].slot == -1)
+      break;
+  }
+  if(i == NSWAPCACHE){
+    i = swapcache.next;
+    swapcache.next = (swapcache.next + 1) % NSWAPCACHE;
+    kfree(swapcache.page[i].pa);
+  }
+  swapcache.page[i].slot = slot;
+  swapcache.page[i].pa = pa;
+  release(&swapcache.lock);
+}
+
+// Read k pages from slots first.. into pa[] with one request
+// and add them to the swap cache.
+static void
+readrun(int first, void **pa, int k)
+{
+  virtio_disk_rwraw(slot2sector(first), pa, k, PGSIZE, 0);
+  zswap_miss(k);
+  for(int j = 0; j < k; j++)
+    swap_cache_put(first + j, pa[j]);
+}
+
+// Read the n slots in slots[] into the swap cache, skipping
+// those already there and those in the compressed pool, which
+// are as quick to fault in as the cache. Runs of consecutive
+// slots are read with one request each. The caller must hold a
+// reference to every slot.
+void
+swap_readahead(int *slots, int n)
+{
+  void *pa[SWAPCLUSTER];
+  int first = -1, k = 0;
+
+  for(int i = 0; i < n; i++){
+    if(swap_cached(slots[i]) || zswap_has(slots[i]))
+      continue;
+    if(k > 0 && (k == SWAPCLUSTER || slots[i] != first + k)){
+      readrun(first, pa, k);
+      k = 0;
+    }
+    if((pa[k] = kalloc()) == 0)
+      break;
+    if(k == 0)
+      first = slots[i];
+    k++;
+  }
+  if(k > 0)
+    readrun(first, pa, k);
+}
@@ -0,0 +1,486 @@
+// Page replacement policies.
+//
+// Each process has its own policy, chosen with set_swap_policy()
+// and inherited across fork and exec; the first process starts
+// with the one named by SWAP_ALGO in the Makefile. A policy is a
+// table of hooks that the paging code in vm.c calls:
+//
+//   select  pick the resident page to evict, or return -1.
+//           only pages that pageoutd has not cleaned count.
+//           preclean() also asks, for pages that stay
+//           resident, so select must not treat its pick as
+//           gone; that is what evict is for.
+//   add     a page has just become resident.
+//   evict   a page is leaving memory.
+//   tick    n aging passes went by since the page was last
+//           sampled.
+//   access  policy_tick() found the page's PTE_A set, and
+//           cleared it.
+//
+// Policies without an access hook read PTE_A themselves when
+// they select a victim, so policy_tick() leaves it alone.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "pgstat.h"
+#include "proc.h"
+#include "defs.h"
+#include "swappolicy.h"
+#include "madvise.h"
+
+struct swap_policy {
+  int (*select)(struct proc*);
+  void (*add)(struct proc*, struct memory_page_entry*);
+  void (*access)(struct proc*, struct memory_page_entry*);
+  void (*tick)(struct proc*, struct memory_page_entry*, uint);
+  void (*evict)(struct proc*, struct memory_page_entry*);
+};
+
+static int
+candidate(struct memory_page_entry *mpe)
+{
+  return mpe->present == 1 && !mpe->cleaned;
+}
+
+//
+// NFUA and LAPA: an aging counter per page, shifted right every
+// aging pass, with the top bit set if the page was accessed.
+//
+
+// The age of mpe as of now, counting the passes since it
+// was last sampled.
+static uint
+age_of(struct paging_metadata *pmd, struct memory_page_entry *mpe)
+{
+  uint n = pmd->age_clock - mpe->aged;
+  return n < 32 ? (mpe->age >> n) : 0;
+}
+
+static void
+age_tick(struct proc *p, struct memory_page_entry *mpe, uint n)
+{
+  mpe->age = n < 32 ? (mpe->age >> n) : 0; //shift right by one bit a pass
+}
+
+static void
+age_access(struct proc *p, struct memory_page_entry *mpe)
+{
+  mpe->age |= 1 << 31; //add 1 to msb
+}
+
+static void
+nfua_add(struct proc *p, struct memory_page_entry *mpe)
+{
+  mpe->age = 0;
+}
+
+static void
+lapa_add(struct proc *p, struct memory_page_entry *mpe)
+{
+  mpe->age = 0xFFFFFFFF;
+}
+
+static int
+nfua_select(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  uint min = 0;
+  int index = -1, i;
+  for_each_entry(i, &pmd->mem){
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    if(candidate(mpe) && (index < 0 || age_of(pmd, mpe) < min)){
+      min = age_of(pmd, mpe);
+      index = i;
+    }
+  }
+  #ifdef YES
+  printf("nfua_select: index: %d with age:%d\n", index, min);
+  #endif
+  return index;
+}
+
+static int
+countSetBits(uint n)
+{
+    int count = 0;
+    while (n) {
+        count += n & 1;
+        n >>= 1;
+    }
+    return count;
+}
+
+static int
+lapa_select(struct proc *p)
+{
+  int index = -1, i;
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int min_count = 0;
+  for_each_entry(i, &pmd->mem){
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    if(!candidate(mpe))
+      continue;
+    int count = countSetBits(age_of(pmd, mpe));
+    if(index < 0 || count < min_count){
+      min_count = count;
+      index = i;
+    }
+    else if(count == min_count){
+      if(age_of(pmd, mpe) < age_of(pmd, MPE(pmd, index))){
+        index = i;
+      }
+    }
+  }
+  #ifdef YES
+  printf("lapa_select: index: %d with min count:%d\n", index, min_count);
+  #endif
+  return index;
+}
+
+//
+// SCFIFO: pages in order of arrival; one that was accessed
+// since it was last considered goes to the back instead.
+//
+
+static void
+order_add(struct proc *p, struct memory_page_entry *mpe)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  mpe->order = pmd->order_counter;
+  pmd->order_counter++;
+}
+
+static int
+find_min_order(struct proc *p)
+{
+  int index= -1, i;
+  int min_order = __INT_MAX__;
+  struct paging_metadata *pmd =&p->paging_metadata;
+  for_each_entry(i, &pmd->mem){
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    if(candidate(mpe) && mpe->order < min_order){
+      min_order = mpe->order;
+      index = i;
+    }
+  }
+  return index;
+}
+
+static int
+scfifo_select(struct proc *p)
+{
+  int index = find_min_order(p);
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int bool = 0;
+  while(bool==0 && index >= 0){
+    struct memory_page_entry *found_mpe = MPE(pmd, index);
+    pte_t* pte = walk(p->pagetable,found_mpe->va,0);
+    if((*pte & PTE_A)!=0) { //access flag is on
+      *pte &=~ PTE_A; //trun off the access flag
+      found_mpe->order= pmd->order_counter; //gets new order
+      pmd->order_counter++;
+      index = find_min_order(p);
+    }
+    else{
+      bool = 1;
+    }
+  }
+  #ifdef YES
+  printf("scfifo_select: index: %d\n", index);
+  #endif
+  return index;
+}
+
+//
+// CLOCK: a hand sweeps over the resident page index, giving
+// each accessed page a second chance by clearing PTE_A.
+//
+
+static int
+clock_select(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+
+  // two sweeps clear every PTE_A seen in the first.
+  for(int n = 0; n < 2*pmd->mem.n; n++){
+    int i = pgindex_next(&pmd->mem, pmd->clock_hand);
+    if(i < 0 && (i = pgindex_next(&pmd->mem, 0)) < 0)
+      break;
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    pmd->clock_hand = i + 1;
+    if(!candidate(mpe))
+      continue;
+    pte_t *pte = walk(p->pagetable, mpe->va, 0);
+    if(*pte & PTE_A){
+      *pte &= ~PTE_A;
+      continue;
+    }
+    return i;
+  }
+  return -1;
+}
+
+//
+// ARC: resident pages are split into T1, seen once, and T2,
+// seen again since they became resident. Evicted pages leave
+// their va in ghost list B1 or B2. A fault on a page in B1 means
+// T1 was too small, and grows arc_target, the share of frames
+// T1 gets; a fault on a page in B2 shrinks it. Within T1 and T2
+// pages are evicted least recently used first, by order.
+//
+
+static int
+ghost_find(struct paging_metadata *pmd, int l, uint64 va)
+{
+  for(int i = 0; i < pmd->nghost[l]; i++){
+    if(pmd->ghost[l][i] == va)
+      return i;
+  }
+  return -1;
+}
+
+static void
+ghost_remove(struct paging_metadata *pmd, int l, int i)
+{
+  for(; i + 1 < pmd->nghost[l]; i++)
+    pmd->ghost[l][i] = pmd->ghost[l][i+1];
+  pmd->nghost[l]--;
+}
+
+static void
+ghost_add(struct paging_metadata *pmd, int l, uint64 va)
+{
+  if(pmd->nghost[l] == ARC_NGHOST)
+    ghost_remove(pmd, l, 0);   // forget the oldest
+  pmd->ghost[l][pmd->nghost[l]++] = va;
+}
+
+static void
+arc_add(struct proc *p, struct memory_page_entry *mpe)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int i, n1 = pmd->nghost[0], n2 = pmd->nghost[1];
+
+  mpe->list = 1;
+  if((i = ghost_find(pmd, 0, mpe->va)) >= 0){
+    pmd->arc_target += (n2 > n1 ? n2 / n1 : 1);
+    if(pmd->arc_target > pmd->mem.limit)
+      pmd->arc_target = pmd->mem.limit;
+    ghost_remove(pmd, 0, i);
+    mpe->list = 2;
+  } else if((i = ghost_find(pmd, 1, mpe->va)) >= 0){
+    pmd->arc_target -= (n1 > n2 ? n1 / n2 : 1);
+    if(pmd->arc_target < 0)
+      pmd->arc_target = 0;
+    ghost_remove(pmd, 1, i);
+    mpe->list = 2;
+  }
+  order_add(p, mpe);
+}
+
+static void
+arc_access(struct proc *p, struct memory_page_entry *mpe)
+{
+  mpe->list = 2;
+  order_add(p, mpe);
+}
+
+static int
+arc_select(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int lru[3] = { -1, -1, -1 };
+  int size[3] = { 0, 0, 0 };
+  int l, i;
+
+  for_each_entry(i, &pmd->mem){
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    l = mpe->list;
+    size[l]++;
+    if(candidate(mpe) && (lru[l] < 0 || mpe->order < MPE(pmd, lru[l])->order))
+      lru[l] = i;
+  }
+  if(lru[1] >= 0 && (size[1] > pmd->arc_target || lru[2] < 0))
+    l = 1;
+  else
+    l = 2;
+  return lru[l];
+}
+
+static void
+arc_evict(struct proc *p, struct memory_page_entry *mpe)
+{
+  if(mpe->list > 0)
+    ghost_add(&p->paging_metadata, mpe->list - 1, mpe->va);
+}
+
+static struct swap_policy policies[NSWAPPOLICY] = {
+[SWAP_NFUA]   { nfua_select,   nfua_add,  age_access, age_tick, 0 },
+[SWAP_LAPA]   { lapa_select,   lapa_add,  age_access, age_tick, 0 },
+[SWAP_SCFIFO] { scfifo_select, order_add, 0,          0,        0 },
+[SWAP_CLOCK]  { clock_select,  0,         0,          0,        0 },
+[SWAP_ARC]    { arc_select,    arc_add,   arc_access, 0,        arc_evict },
+};
+
+// The resident page of p furthest behind the last fault in a
+// range given MADV_SEQUENTIAL, which should not be needed again
+// soon, or -1.
+static int
+evict_behind(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  struct madvrange *r;
+  int index = -1, i;
+
+  if(pmd->nmadv == 0)
+    return -1;
+  for_each_entry(i, &pmd->mem){
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    if(!candidate(mpe) || (r = madv_find(p, mpe->va)) == 0)
+      continue;
+    if(r->advice == MADV_SEQUENTIAL && mpe->va < r->last &&
+       (index < 0 || mpe->va < MPE(pmd, index)->va))
+      index = i;
+  }
+  return index;
+}
+
+// Choose the resident page of p to evict next: one that
+// madvise() said was left behind, or else the policy's pick.
+int
+index_to_swap(struct proc *p)
+{
+  int i;
+
+  if((i = evict_behind(p)) >= 0)
+    return i;
+  return policies[p->swap_policy].select(p);
+}
+
+// Tell p's policy that mpe has just become resident.
+void
+policy_add(struct proc *p, struct memory_page_entry *mpe)
+{
+  struct swap_policy *sp = &policies[p->swap_policy];
+
+  mpe->aged = p->paging_metadata.age_clock;
+  if(sp->add)
+    sp->add(p, mpe);
+}
+
+// Estimate the working set of p: the resident pages used in
+// the last WSWINDOW aging passes. The aging policies keep that
+// history in each page's age. The others only have PTE_A, set
+// since the policy last cleared it, so for them this is a
+// rough estimate of recent use, not a count over the window.
+static void
+ws_update(struct proc *p)
+{
+  struct swap_policy *sp = &policies[p->swap_policy];
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int i, wss = 0;
+
+  for_each_entry(i, &pmd->mem){
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    if(sp->tick){
+      if(age_of(pmd, mpe) >> (32 - WSWINDOW))
+        wss++;
+    } else {
+      pte_t *pte = walk(p->pagetable, mpe->va, 0);
+      if(pte && (*pte & PTE_A))
+        wss++;
+    }
+  }
+  pmd->wss = wss;
+  reclaim_setcold(p, pmd->mem.n - wss);
+}
+
+// Tell p's policy that mpe is leaving memory.
+void
+policy_evict(struct proc *p, struct memory_page_entry *mpe)
+{
+  struct swap_policy *sp = &policies[p->swap_policy];
+
+  if(sp->evict)
+    sp->evict(p, mpe);
+}
+
+// An aging pass, run from the timer interrupt every AGEINTERVAL
+// ticks that p spends in user space. It samples the next
+// AGESAMPLE resident pages of p, going round all of them over
+// successive passes: each is aged by the passes it missed since
+// its last sample, then reported if it was accessed meanwhile.
+// With AGESAMPLE at least the resident set this ages every page
+// on every pass.
+void
+policy_tick(struct proc *p)
+{
+  struct swap_policy *sp = &policies[p->swap_policy];
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int i, n;
+
+  pmd->age_clock++;
+  if(pmd->age_clock % WSINTERVAL == 0)
+    ws_update(p);
+  if(sp->tick == 0 && sp->access == 0)
+    return;
+  for(n = 0; n < AGESAMPLE && n < pmd->mem.n; n++){
+    i = pgindex_next(&pmd->mem, pmd->age_hand);
+    if(i < 0 && (i = pgindex_next(&pmd->mem, 0)) < 0)
+      break;
+    pmd->age_hand = i + 1;
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    if(sp->tick)
+      sp->tick(p, mpe, pmd->age_clock - mpe->aged);
+    mpe->aged = pmd->age_clock;
+    if(sp->access == 0)
+      continue;
+    pte_t *pte = walk(p->pagetable, mpe->va, 0);
+    if(pte && (*pte & PTE_A)){ //if accessed
+      *pte &= ~PTE_A; //reset PTE_A flag
+      sp->access(p, mpe);
+    }
+  }
+}
+
+// Forget the policy state of p, for exec and freeproc.
+void
+policy_reset(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+
+  pmd->order_counter = 0;
+  pmd->clock_hand = 0;
+  pmd->age_hand = 0;
+  pmd->arc_target = 0;
+  pmd->nghost[0] = pmd->nghost[1] = 0;
+}
+
+// Start p's policy over as if every resident page had just
+// been added, for exec and set_swap_policy().
+void
+policy_restart(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int i;
+
+  policy_reset(p);
+  for_each_entry(i, &pmd->mem)
+    policy_add(p, MPE(pmd, i));
+}
+
+// Switch the current process to policy.
+int
+set_swap_policy(int policy)
+{
+  struct proc *p = myproc();
+
+  if(policy < 0 || policy >= NSWAPPOLICY)
+    return -1;
+  p->swap_policy = policy;
+  policy_restart(p);
+  return 0;
+}
@@ -0,0 +1,16 @@
+// Page replacement policies, as passed to set_swap_policy().
+#define SWAP_NFUA    0  // not frequently used, with aging
+#define SWAP_LAPA    1  // least accessed page, with aging
+#define SWAP_SCFIFO  2  // second-chance FIFO
+#define SWAP_CLOCK   3  // clock over the resident page table
+#define SWAP_ARC     4  // adaptive replacement cache
+#define NSWAPPOLICY  5
+
+// the policy of the first process, from SWAP_ALGO in the Makefile.
+#if defined(NFUA)
+#define SWAP_DEFAULT SWAP_NFUA
+#elif defined(LAPA)
+#define SWAP_DEFAULT SWAP_LAPA
+#else
+#define SWAP_DEFAULT SWAP_SCFIFO
+#endif
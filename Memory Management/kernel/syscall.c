@@ -3,6 +3,7 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "pgstat.h"
 #include "proc.h"
 #include "syscall.h"
 #include "defs.h"
@@ -101,6 +102,15 @@ extern uint64 sys_unlink(void);
 extern uint64 sys_link(void);
 extern uint64 sys_mkdir(void);
 extern uint64 sys_close(void);
+extern uint64 sys_getpgstat(void);
+extern uint64 sys_set_swap_policy(void);
+extern uint64 sys_set_paging_limits(void);
+extern uint64 sys_getmemstat(void);
+extern uint64 sys_getslabstat(void);
+extern uint64 sys_madvise(void);
+extern uint64 sys_shmget(void);
+extern uint64 sys_shmat(void);
+extern uint64 sys_shmdt(void);
 
 // An array mapping syscall numbers from syscall.h
 // to the function that handles the system call.
@@ -126,6 +136,15 @@ static uint64 (*syscalls[])(void) = {
 [SYS_link]    sys_link,
 [SYS_mkdir]   sys_mkdir,
 [SYS_close]   sys_close,
+[SYS_getpgstat] sys_getpgstat,
+[SYS_set_swap_policy] sys_set_swap_policy,
+[SYS_set_paging_limits] sys_set_paging_limits,
+[SYS_getmemstat] sys_getmemstat,
+[SYS_getslabstat] sys_getslabstat,
+[SYS_madvise] sys_madvise,
+[SYS_shmget]  sys_shmget,
+[SYS_shmat]   sys_shmat,
+[SYS_shmdt]   sys_shmdt,
 };
 
 void
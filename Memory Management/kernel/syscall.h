@@ -20,3 +20,12 @@
 #define SYS_link   19
 #define SYS_mkdir  20
 #define SYS_close  21
+#define SYS_getpgstat 22
+#define SYS_set_swap_policy 23
+#define SYS_set_paging_limits 24
+#define SYS_getmemstat 25
+#define SYS_getslabstat 26
+#define SYS_madvise 27
+#define SYS_shmget 28
+#define SYS_shmat  29
+#define SYS_shmdt  30
@@ -10,6 +10,7 @@
 #include "param.h"
 #include "stat.h"
 #include "spinlock.h"
+#include "pgstat.h"
 #include "proc.h"
 #include "fs.h"
 #include "sleeplock.h"
@@ -308,7 +309,7 @@ sys_open(void)
   int fd, omode;
   struct file *f;
   struct inode *ip;
-  int n;
+  int n, writable, trunc;
 
   argint(1, &omode);
   if((n = argstr(0, path, MAXPATH)) < 0)
@@ -341,9 +342,19 @@ sys_open(void)
     return -1;
   }
 
+  writable = (omode & O_WRONLY) || (omode & O_RDWR);
+  trunc = (omode & O_TRUNC) && ip->type == T_FILE;
+  if(ip->type == T_FILE && (writable || trunc) && igetwrite(ip) < 0){
+    iunlockput(ip);   // a running program
+    end_op();
+    return -1;
+  }
+
   if((f = filealloc()) == 0 || (fd = fdalloc(f)) < 0){
     if(f)
       fileclose(f);
+    if(ip->type == T_FILE && (writable || trunc))
+      iputwrite(ip);
     iunlockput(ip);
     end_op();
     return -1;
@@ -358,10 +369,12 @@ sys_open(void)
   }
   f->ip = ip;
   f->readable = !(omode & O_WRONLY);
-  f->writable = (omode & O_WRONLY) || (omode & O_RDWR);
+  f->writable = writable;
 
-  if((omode & O_TRUNC) && ip->type == T_FILE){
+  if(trunc){
     itrunc(ip);
+    if(!writable)
+      iputwrite(ip);
   }
 
   iunlock(ip);
@@ -4,6 +4,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "spinlock.h"
+#include "pgstat.h"
 #include "proc.h"
 
 uint64
@@ -89,3 +90,122 @@ sys_uptime(void)
   release(&tickslock);
   return xticks;
 }
+
+// report the physical memory allocator's counters;
+// see struct memstat.
+uint64
+sys_getmemstat(void)
+{
+  uint64 addr;
+
+  argaddr(0, &addr);
+  return getmemstat(addr);
+}
+
+// report the counters of the i'th slab cache;
+// see struct slabstat.
+uint64
+sys_getslabstat(void)
+{
+  int i;
+  uint64 addr;
+
+  argint(0, &i);
+  argaddr(1, &addr);
+  return getslabstat(i, addr);
+}
+
+// report the paging counters of a process, or of the
+// whole system if pid is 0; see struct pgstat.
+uint64
+sys_getpgstat(void)
+{
+  int pid;
+  uint64 addr;
+
+  argint(0, &pid);
+  argaddr(1, &addr);
+  return getpgstat(pid, addr);
+}
+
+// choose the page replacement policy of the calling
+// process; see swappolicy.h.
+uint64
+sys_set_swap_policy(void)
+{
+  int policy;
+
+  argint(0, &policy);
+  #ifdef NONE
+  return -1;
+  #else
+  return set_swap_policy(policy);
+  #endif
+}
+
+// set how many pages the current process may keep
+// in memory and in swap.
+uint64
+sys_set_paging_limits(void)
+{
+  int resident, swapped;
+
+  argint(0, &resident);
+  argint(1, &swapped);
+  #ifdef NONE
+  return -1;
+  #else
+  return set_paging_limits(resident, swapped);
+  #endif
+}
+
+// tell the kernel how the current process will use a
+// range of its memory; see madvise().
+uint64
+sys_madvise(void)
+{
+  uint64 addr;
+  int len, advice;
+
+  argaddr(0, &addr);
+  argint(1, &len);
+  argint(2, &advice);
+  #ifdef NONE
+  return -1;
+  #else
+  return madvise(addr, len, advice);
+  #endif
+}
+
+// find or create the shared memory segment with a key.
+uint64
+sys_shmget(void)
+{
+  int key, npages;
+
+  argint(0, &key);
+  argint(1, &npages);
+  return shmget(key, npages);
+}
+
+// map a shared memory segment at a chosen address.
+uint64
+sys_shmat(void)
+{
+  int id;
+  uint64 va;
+
+  argint(0, &id);
+  argaddr(1, &va);
+  return shmat(id, va);
+}
+
+// unmap a shared memory segment.
+uint64
+sys_shmdt(void)
+{
+  uint64 va;
+
+  argaddr(0, &va);
+  return shmdt(va);
+}
@@ -3,6 +3,7 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "pgstat.h"
 #include "proc.h"
 #include "defs.h"
 
@@ -68,14 +69,33 @@ usertrap(void)
   } else if((which_dev = devintr()) != 0){
     // ok
   
+  } else if(r_scause() == 15 && uvmiscow(p->pagetable, r_stval())){
+    // write to a page shared copy-on-write by fork.
+    PGSTAT_ADD(p, faults, 1);
+    PGSTAT_ADD(p, minfaults, 1);
+    if(cow_fault(p->pagetable, r_stval()) < 0)
+      setkilled(p);
+  } else if((r_scause() == 12 || r_scause() == 13 || r_scause() == 15) && uvmislazy(p, r_stval())){
+    // first touch of a heap page reserved by sbrk(), or of
+    // a page of the program that exec did not load.
+    PGSTAT_ADD(p, faults, 1);
+    PGSTAT_ADD(p, minfaults, 1);
+    if(lazy_alloc(p, r_stval(), r_scause() == 15) < 0)
+      setkilled(p);
+    #ifndef NONE
+    else
+      preclean(p);
+    #endif
   } //task2
   #ifndef NONE
-  else if(r_scause() == 13 || r_scause() == 15){
+  else if(r_scause() == 12 || r_scause() == 13 || r_scause() == 15){
     //printf("page fault\n");
+    PGSTAT_ADD(p, faults, 1);
     uint64 address = r_stval();
     if(swap_in_memory(p, address)==-1){
       panic("swap_in_memory failed\n");
     }
+    preclean(p);
   }
   #endif 
   else {
@@ -88,8 +108,22 @@ usertrap(void)
     exit(-1);
 
   // give up the CPU if this is a timer interrupt.
-  if(which_dev == 2)
+  if(which_dev == 2){
+    // age p's pages every AGEINTERVAL ticks of its user time,
+    // here, where none of its paging code can be running.
+    #ifndef NONE
+    if(++p->paging_metadata.agetick >= AGEINTERVAL){
+      p->paging_metadata.agetick = 0;
+      policy_tick(p);
+      reclaim_tick(p);
+    }
+    if(KSMINTERVAL > 0 && ++p->paging_metadata.ksmtick >= KSMINTERVAL){
+      p->paging_metadata.ksmtick = 0;
+      ksm_tick(p);
+    }
+    #endif
     yield();
+  }
 
   usertrapret();
 }
@@ -6,7 +6,9 @@
 #include "defs.h"
 #include "fs.h"
 #include "spinlock.h"
+#include "pgstat.h"
 #include "proc.h"
+#include "madvise.h"
 
 
 /*
@@ -73,6 +75,32 @@ kvminithart()
   sfence_vma();
 }
 
+// Return the address of the PTE at level stop in page table
+// pagetable that corresponds to virtual address va, or of the
+// level-1 leaf PTE if va is in a megapage. If alloc!=0, create
+// any required page-table pages.
+static pte_t *
+walklevel(pagetable_t pagetable, uint64 va, int alloc, int stop)
+{
+  if(va >= MAXVA)
+    panic("walk");
+
+  for(int level = 2; level > stop; level--) {
+    pte_t *pte = &pagetable[PX(level, va)];
+    if(*pte & PTE_V) {
+      if(PTE_LEAF(*pte))
+        return pte;
+      pagetable = (pagetable_t)PTE2PA(*pte);
+    } else {
+      if(!alloc || (pagetable = (pde_t*)kalloc()) == 0)
+        return 0;
+      memset(pagetable, 0, PGSIZE);
+      *pte = PA2PTE(pagetable) | PTE_V;
+    }
+  }
+  return &pagetable[PX(stop, va)];
+}
+
 // Return the address of the PTE in page table pagetable
 // that corresponds to virtual address va.  If alloc!=0,
 // create any required page-table pages.
@@ -85,24 +113,14 @@ kvminithart()
 //   21..29 -- 9 bits of level-1 index.
 //   12..20 -- 9 bits of level-0 index.
 //    0..11 -- 12 bits of byte offset within the page.
+//
+// A level-1 PTE can also be a leaf that maps a whole 2 MB
+// megapage, in which case walk() returns it. Only the kernel
+// page table has megapages.
 pte_t *
 walk(pagetable_t pagetable, uint64 va, int alloc)
 {
-  if(va >= MAXVA)
-    panic("walk");
-
-  for(int level = 2; level > 0; level--) {
-    pte_t *pte = &pagetable[PX(level, va)];
-    if(*pte & PTE_V) {
-      pagetable = (pagetable_t)PTE2PA(*pte);
-    } else {
-      if(!alloc || (pagetable = (pde_t*)kalloc()) == 0)
-        return 0;
-      memset(pagetable, 0, PGSIZE);
-      *pte = PA2PTE(pagetable) | PTE_V;
-    }
-  }
-  return &pagetable[PX(0, va)];
+  return walklevel(pagetable, va, alloc, 0);
 }
 
 // Look up a virtual address, return the physical address,
@@ -134,10 +152,46 @@ walkaddr(pagetable_t pagetable, uint64 va)
 void
 kvmmap(pagetable_t kpgtbl, uint64 va, uint64 pa, uint64 sz, int perm)
 {
+#ifdef NOMEGAPAGES
   if(mappages(kpgtbl, va, sz, pa, perm) != 0)
+#else
+  if(mapmegapages(kpgtbl, va, sz, pa, perm) != 0)
+#endif
     panic("kvmmap");
 }
 
+// Like mappages(), but map each 2 MB stretch where va and pa
+// are both megapage-aligned with a single level-1 leaf PTE,
+// which saves a page-table page and covers 512 times as much
+// memory per TLB entry. va and size must be page-aligned.
+int
+mapmegapages(pagetable_t pagetable, uint64 va, uint64 size, uint64 pa, int perm)
+{
+  uint64 end = va + size, n;
+  pte_t *pte;
+
+  while(va < end){
+    if(va % MEGAPGSIZE == 0 && pa % MEGAPGSIZE == 0 && end - va >= MEGAPGSIZE){
+      if((pte = walklevel(pagetable, va, 1, 1)) == 0)
+        return -1;
+      if(*pte & PTE_V)
+        panic("mapmegapages: remap");
+      *pte = PA2PTE(pa) | perm | PTE_V;
+      n = MEGAPGSIZE;
+    } else {
+      // small pages up to the next megapage boundary.
+      n = MEGAPGSIZE - va % MEGAPGSIZE;
+      if(n > end - va)
+        n = end - va;
+      if(mappages(pagetable, va, n, pa, perm) != 0)
+        return -1;
+    }
+    va += n;
+    pa += n;
+  }
+  return 0;
+}
+
 // Create PTEs for virtual addresses starting at va that refer to
 // physical addresses starting at pa. va and size might not
 // be page-aligned. Returns 0 on success, -1 if walk() couldn't
@@ -168,10 +222,11 @@ mappages(pagetable_t pagetable, uint64 va, uint64 size, uint64 pa, int perm)
 }
 
 // Remove npages of mappings starting from va. va must be
-// page-aligned. The mappings must exist.
-// Optionally free the physical memory.
-void
-uvmunmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free)
+// page-aligned. The mappings must exist, except that pages
+// below sz may never have been touched (see uvmislazy()), with
+// no PTE or an all-zero one. Optionally free the physical memory.
+static void
+unmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free, uint64 sz)
 {
   //printf("uvmunmap: va = %p, npages = %d, do free= %d\n", va, npages, do_free);
   uint64 a;
@@ -181,7 +236,10 @@ uvmunmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free)
     panic("uvmunmap: not aligned");
 
   for(a = va; a < va + npages*PGSIZE; a += PGSIZE){
-    if((pte = walk(pagetable, a, 0)) == 0)
+    pte = walk(pagetable, a, 0);
+    if(a < sz && (pte == 0 || *pte == 0))
+      continue;
+    if(pte == 0)
       panic("uvmunmap: walk");
     if((*pte & PTE_V) == 0 && (*pte & PTE_PG) == 0) //cleared but not swaped out 
       panic("uvmunmap: not mapped");
@@ -208,6 +266,41 @@ uvmunmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free)
 
     *pte = 0;
   }
+  uvmflush(pagetable, va, npages);
+}
+
+// Remove npages of mappings starting from va. va must be
+// page-aligned. The mappings must exist.
+// Optionally free the physical memory.
+void
+uvmunmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free)
+{
+  unmap(pagetable, va, npages, do_free, 0);
+}
+
+// Flush the TLB entries for npages pages at va in pagetable,
+// after their PTEs changed.
+//
+// Only this hart can hold them, and only if pagetable is loaded
+// here: harts switch to a user page table in userret and away in
+// uservec, flushing the whole TLB both times, and each user page
+// table belongs to one single-threaded process, so while the
+// kernel changes p's PTEs on p's behalf, no hart runs p in user
+// space. That leaves the kernel page table, whose pages are
+// flushed one by one up to a limit and all at once beyond it.
+#define FLUSH_MAX 32
+
+void
+uvmflush(pagetable_t pagetable, uint64 va, uint64 npages)
+{
+  if(r_satp() != MAKE_SATP(pagetable))
+    return;
+  if(npages > FLUSH_MAX){
+    sfence_vma();
+    return;
+  }
+  for(uint64 a = PGROUNDDOWN(va); npages > 0; a += PGSIZE, npages--)
+    sfence_vma_va(a);
 }
 
 // create an empty user page table.
@@ -289,7 +382,7 @@ uvmdealloc(pagetable_t pagetable, uint64 oldsz, uint64 newsz)
 
   if(PGROUNDUP(newsz) < PGROUNDUP(oldsz)){
     int npages = (PGROUNDUP(oldsz) - PGROUNDUP(newsz)) / PGSIZE;
-    uvmunmap(pagetable, PGROUNDUP(newsz), npages, 1);
+    unmap(pagetable, PGROUNDUP(newsz), npages, 1, oldsz);
   }
 
   return newsz;
@@ -321,14 +414,15 @@ void
 uvmfree(pagetable_t pagetable, uint64 sz)
 {
   if(sz > 0)
-    uvmunmap(pagetable, 0, PGROUNDUP(sz)/PGSIZE, 1);
+    unmap(pagetable, 0, PGROUNDUP(sz)/PGSIZE, 1, sz);
   freewalk(pagetable);
 }
 
 // Given a parent process's page table, copy
 // its memory into a child's page table.
-// Copies both the page table and the
-// physical memory.
+// Copies the page table, but shares the physical
+// memory: writable pages become read-only PTE_COW
+// in both tables and are copied on the first write.
 // returns 0 on success, -1 on failure.
 // frees any allocated pages on failure.
 
@@ -341,11 +435,11 @@ uvmcopy(pagetable_t old, pagetable_t new, uint64 sz)
   pte_t *pte;
   uint64 pa, i;
   uint flags;
-  char *mem;
 
   for(i = 0; i < sz; i += PGSIZE){
-    if((pte = walk(old, i, 0)) == 0)
-      panic("uvmcopy: pte should exist");
+    // pages that were never touched stay lazy in the child.
+    if((pte = walk(old, i, 0)) == 0 || *pte == 0)
+      continue;
     if((*pte & PTE_V) == 0 && (*pte & PTE_PG) == 0) //cleared but not swaped out
       panic("uvmcopy: page not present");
     //task2
@@ -358,22 +452,70 @@ uvmcopy(pagetable_t old, pagetable_t new, uint64 sz)
     }
     #endif
     pa = PTE2PA(*pte);
+    if(*pte & PTE_W)
+      *pte = (*pte & ~PTE_W) | PTE_COW;
     flags = PTE_FLAGS(*pte);
-    if((mem = kalloc()) == 0)
-      goto err;
-    memmove(mem, (char*)pa, PGSIZE);
-    if(mappages(new, i, PGSIZE, (uint64)mem, flags) != 0){
-      kfree(mem);
+    if(mappages(new, i, PGSIZE, pa, flags) != 0)
       goto err;
-    }
+    kdup((void*)pa);
   }
+  // the parent's writable PTEs just became read-only.
+  uvmflush(old, 0, PGROUNDUP(sz) / PGSIZE);
   return 0;
 
  err:
-  uvmunmap(new, 0, i / PGSIZE, 1);
+  unmap(new, 0, i / PGSIZE, 1, i);
+  uvmflush(old, 0, i / PGSIZE);
   return -1;
 }
 
+// Is va a resident copy-on-write user page in pagetable?
+int
+uvmiscow(pagetable_t pagetable, uint64 va)
+{
+  pte_t *pte;
+
+  if(va >= MAXVA)
+    return 0;
+  pte = walk(pagetable, va, 0);
+  if(pte == 0)
+    return 0;
+  return (*pte & (PTE_V|PTE_U|PTE_COW)) == (PTE_V|PTE_U|PTE_COW);
+}
+
+// Handle a write to the copy-on-write page at va: give
+// pagetable its own writable copy. The last sharer takes the
+// page over without copying. The page stays in the process's
+// paging_metadata under the same va, so the resident and swap
+// bookkeeping is unaffected.
+// Returns 0 on success, -1 if va is not COW or out of memory.
+int
+cow_fault(pagetable_t pagetable, uint64 va)
+{
+  pte_t *pte;
+  uint64 pa;
+  uint flags;
+  char *mem;
+
+  va = PGROUNDDOWN(va);
+  if(!uvmiscow(pagetable, va))
+    return -1;
+  pte = walk(pagetable, va, 0);
+  pa = PTE2PA(*pte);
+  flags = (PTE_FLAGS(*pte) & ~PTE_COW) | PTE_W;
+  if(krefcnt((void*)pa) == 1){
+    *pte = PA2PTE(pa) | flags;
+  } else {
+    if((mem = kalloc()) == 0)
+      return -1;
+    memmove(mem, (char*)pa, PGSIZE);
+    *pte = PA2PTE(mem) | flags;
+    kfree((void*)pa);
+  }
+  uvmflush(pagetable, va, 1);
+  return 0;
+}
+
 // mark a PTE invalid for user access.
 // used by exec for the user stack guard page.
 void
@@ -387,6 +529,139 @@ uvmclear(pagetable_t pagetable, uint64 va)
   *pte &= ~PTE_U;
 }
 
+// Is va a page of p that was never touched: a heap page that
+// sbrk() reserved, or a page of the program that exec did not
+// load? growproc() and exec only move p->sz, so such pages have
+// no PTE, or an all-zero one.
+int
+uvmislazy(struct proc *p, uint64 va)
+{
+  pte_t *pte;
+
+  if(va >= p->sz)
+    return 0;
+  pte = walk(p->pagetable, va, 0);
+  return pte == 0 || (*pte & (PTE_V|PTE_PG)) == 0;
+}
+
+// The segment of p's program that holds va, or 0.
+static struct execseg*
+execseg(struct proc *p, uint64 va)
+{
+  for(int i = 0; i < p->nseg; i++){
+    struct execseg *s = &p->seg[i];
+    if(va >= s->va && va < s->va + s->memsz)
+      return s;
+  }
+  return 0;
+}
+
+// Back the untouched page at va with a page of its own, and
+// only now count it in p's resident set. A page of the program
+// is read from the program file through the buffer cache, so
+// this may sleep; other pages are zeroed. If the page would be
+// all zeros and this is not a write, it maps the shared zero
+// page instead, copy-on-write. The caller must not hold an
+// inode lock, or a program page may need the same one.
+// Returns 0 on success, -1 if va is not lazy, out of memory,
+// or the file is short.
+int
+lazy_alloc(struct proc *p, uint64 va, int write)
+{
+  struct execseg *s;
+  char *mem;
+  int perm = PTE_R|PTE_W|PTE_U;
+  uint n;
+
+  va = PGROUNDDOWN(va);
+  if(!uvmislazy(p, va))
+    return -1;
+  s = execseg(p, va);
+  if(s)
+    perm = PTE_R|PTE_U|s->perm;
+  if(!write && (s == 0 || va >= s->va + s->filesz)){
+    mem = ksm_zeropage();
+    kdup(mem);
+    if(perm & PTE_W)
+      perm = (perm & ~PTE_W) | PTE_COW;
+  } else {
+    if((mem = kalloc()) == 0)
+      return -1;
+    memset(mem, 0, PGSIZE);
+    if(s && va < s->va + s->filesz){
+      n = s->va + s->filesz - va;
+      if(n > PGSIZE)
+        n = PGSIZE;
+      ilock(p->exe);
+      if(readi(p->exe, 0, (uint64)mem, s->off + (va - s->va), n) != n){
+        iunlock(p->exe);
+        kfree(mem);
+        return -1;
+      }
+      iunlock(p->exe);
+    }
+  }
+  if(mappages(p->pagetable, va, PGSIZE, (uint64)mem, perm) != 0){
+    kfree(mem);
+    return -1;
+  }
+  #ifndef NONE
+  if(p->pid > 2 && !(p->name[0] == 's' && p->name[1] == 'h' && p->name[3]=='\000')){
+    if(add_to_memory(p, va) == -1)
+      printf("lazy_alloc: add_to_memory failed\n");
+  }
+  #endif
+  return 0;
+}
+
+// Would lazy_alloc() map the zero page at va of p with the
+// same permissions as pte has, were va untouched?
+static int
+zerolazy(struct proc *p, uint64 va, pte_t pte)
+{
+  struct execseg *s = execseg(p, va);
+  int perm = s ? PTE_R|PTE_U|s->perm : PTE_R|PTE_W|PTE_U;
+
+  if(va >= p->sz)
+    return 0;
+  if(perm & PTE_W)
+    perm = (perm & ~PTE_W) | PTE_COW;
+  return (pte & (PTE_R|PTE_W|PTE_X|PTE_U|PTE_COW)) == perm;
+}
+
+// walkaddr() for copyin/copyout: fill in va first if it is
+// an untouched page of the current process.
+static uint64
+uvmwalkaddr(pagetable_t pagetable, uint64 va, int write)
+{
+  struct proc *p = myproc();
+
+  if(p && p->pagetable == pagetable && uvmislazy(p, va))
+    lazy_alloc(p, va, write);
+  return walkaddr(pagetable, va);
+}
+
+// Fill in the untouched pages of the current process from va
+// to va+len, for a caller that is about to copy to or from them
+// while it holds a spinlock, when lazy_alloc() must not sleep,
+// or an inode lock, when it must not read the program file.
+// Filled pages never become untouched again on their own;
+// eviction swaps them out. Returns -1 if one could not be filled.
+int
+uvmprefault(uint64 va, uint64 len)
+{
+  struct proc *p = myproc();
+  uint64 a;
+
+  if(len == 0 || va + len < va)
+    return 0;
+  for(a = PGROUNDDOWN(va); a < va + len && a < p->sz; a += PGSIZE){
+    if(uvmislazy(p, a) && lazy_alloc(p, a, 1) < 0)
+      return -1;
+  }
+  return 0;
+}
+
 // Copy from kernel to user.
 // Copy len bytes from src to virtual address dstva in a given page table.
 // Return 0 on success, -1 on error.
@@ -397,9 +672,13 @@ copyout(pagetable_t pagetable, uint64 dstva, char *src, uint64 len)
 
   while(len > 0){
     va0 = PGROUNDDOWN(dstva);
-    pa0 = walkaddr(pagetable, va0);
+    if(uvmiscow(pagetable, va0) && cow_fault(pagetable, va0) < 0)
+      return -1;
+    pa0 = uvmwalkaddr(pagetable, va0, 1);
     if(pa0 == 0)
       return -1;
+    // the hardware only sets PTE_D for user stores.
+    *walk(pagetable, va0, 0) |= PTE_D;
     n = PGSIZE - (dstva - va0);
     if(n > len)
       n = len;
@@ -422,7 +701,7 @@ copyin(pagetable_t pagetable, char *dst, uint64 srcva, uint64 len)
 
   while(len > 0){
     va0 = PGROUNDDOWN(srcva);
-    pa0 = walkaddr(pagetable, va0);
+    pa0 = uvmwalkaddr(pagetable, va0, 0);
     if(pa0 == 0)
       return -1;
     n = PGSIZE - (srcva - va0);
@@ -449,7 +728,7 @@ copyinstr(pagetable_t pagetable, char *dst, uint64 srcva, uint64 max)
 
   while(got_null == 0 && max > 0){
     va0 = PGROUNDDOWN(srcva);
-    pa0 = walkaddr(pagetable, va0);
+    pa0 = uvmwalkaddr(pagetable, va0, 0);
     if(pa0 == 0)
       return -1;
     n = PGSIZE - (srcva - va0);
@@ -484,70 +763,339 @@ copyinstr(pagetable_t pagetable, char *dst, uint64 srcva, uint64 max)
 int remove_page_from_memory(struct proc *p, uint64 va){
   //printf("remove_page_from_memory: va=%d\n", va);
   struct paging_metadata *pmd =&p->paging_metadata;
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    struct memory_page_entry *mpe = &pmd->memory_page_entries[i];
-    if(mpe->va == va && mpe->present == 1){
-      mpe->va = 0;
-      mpe->age = 0;
-      mpe->present = 0;
-      mpe->offset = 0;
-      mpe->order = 0;
-      pmd->num_in_memory--;
-      return 0;
-    }
-  }
-  return -1;
+  int i = pgindex_find(&pmd->mem, va);
+  if(i < 0)
+    return -1;
+  struct memory_page_entry *mpe = MPE(pmd, i);
+  if(mpe->cleaned)
+    swap_free(mpe->slot);
+  pgindex_remove(&pmd->mem, i);
+  return 0;
 }
 
 int remove_page_from_swapfile(struct proc *p, uint64 va){
   //printf("remove_page_from_swapfile: va=%d\n", va);
   //print_swap_file(p);
   struct paging_metadata *pmd =&p->paging_metadata;
-  for(int i=0; i< MAX_TOTAL_PAGES-MAX_PSYC_PAGES; i++){
-    struct swap_file_entry *sfe = &pmd->swap_file_entries[i];
-    if(sfe->va == va && sfe->present == 1){
-      sfe->va = 0;
-      sfe->present = 0;
-      sfe->offset = 0;
-      pmd->num_in_swap--;
-      return 0;
+  int i = pgindex_find(&pmd->swap, va);
+  if(i < 0)
+    return -1;
+  swap_free(SFE(pmd, i)->offset);
+  pgindex_remove(&pmd->swap, i);
+  return 0;
+}
+
+// Take a reference to every page p has in swap, for a child
+// that was just given a copy of p's paging_metadata.
+void
+dup_swap_entries(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int i;
+  for_each_entry(i, &pmd->swap)
+    swap_dup(SFE(pmd, i)->offset);
+  // pre-cleaned copies stay valid for the child too: its
+  // pages are the parent's until either side writes them.
+  for_each_entry(i, &pmd->mem){
+    if(MPE(pmd, i)->cleaned)
+      swap_dup(MPE(pmd, i)->slot);
+  }
+}
+
+// Drop p's references to its swapped-out pages, for exit
+// and for exec, which discard the whole address space.
+void
+free_swap_entries(struct pgindex *ix)
+{
+  int i;
+  for_each_entry(i, ix){
+    swap_free(((struct swap_file_entry*)pgindex_get(ix, i))->offset);
+    pgindex_remove(ix, i);
+  }
+}
+
+// Drop the swap slots of p's pre-cleaned resident pages,
+// for exit and exec.
+void
+free_clean_pages(struct pgindex *ix)
+{
+  int i;
+  for_each_entry(i, ix){
+    struct memory_page_entry *mpe = pgindex_get(ix, i);
+    if(mpe->cleaned){
+      swap_free(mpe->slot);
+      mpe->cleaned = 0;
     }
   }
-  return -1;
+}
+
+// Page-out daemon.
+//
+// A process that runs short of room for resident pages asks
+// pageoutd to write its next few victims to swap ahead of time.
+// preclean() picks them with the usual replacement policy,
+// clears PTE_D and queues the frames, with a run of contiguous
+// slots, as one cluster; pageoutd writes each cluster with a
+// single disk request. When swap_out_memory() later evicts such
+// a page and it is still clean, it just drops the frame instead
+// of writing it out while the faulting process waits.
+//
+// Only the owning process changes its paging_metadata; the
+// daemon holds a reference to the frames and to the slots, so
+// either may be freed while the write is in flight.
+#define PAGEOUT_LOW  2   // start cleaning below this many free or clean frames
+#define PAGEOUT_HIGH 4   // and stop at this many
+#define NPAGEOUT    16   // queued clusters
+
+struct {
+  struct spinlock lock;
+  int started;
+  int head, n;
+  struct {
+    void *pa[SWAPCLUSTER];
+    int slot;            // first of n contiguous slots
+    int n;
+  } req[NPAGEOUT];
+  char inflight[NSWAPPAGES];   // slot has a queued or running write
+} pageout;
+
+void
+pageoutinit(void)
+{
+  initlock(&pageout.lock, "pageout");
+}
+
+void
+pageoutd(void)
+{
+  void *pa[SWAPCLUSTER];
+  int slot, n;
+
+  acquire(&pageout.lock);
+  for(;;){
+    while(pageout.n == 0)
+      sleep(&pageout, &pageout.lock);
+    slot = pageout.req[pageout.head].slot;
+    n = pageout.req[pageout.head].n;
+    for(int i = 0; i < n; i++)
+      pa[i] = pageout.req[pageout.head].pa[i];
+    pageout.head = (pageout.head + 1) % NPAGEOUT;
+    pageout.n--;
+    release(&pageout.lock);
+
+    swap_writev(slot, pa, n);
+    for(int i = 0; i < n; i++){
+      kfree(pa[i]);
+      swap_free(slot + i);
+    }
+
+    acquire(&pageout.lock);
+    for(int i = 0; i < n; i++){
+      pageout.inflight[slot + i] = 0;
+      wakeup(&pageout.inflight[slot + i]);
+    }
+  }
+}
+
+// Wait for pageoutd to finish writing slot.
+static void
+pageout_wait(int slot)
+{
+  acquire(&pageout.lock);
+  while(pageout.inflight[slot])
+    sleep(&pageout.inflight[slot], &pageout.lock);
+  release(&pageout.lock);
+}
+
+// Queue a write of the n frames pa[] to slots slot.., taking
+// a reference to each. Returns -1 if the queue is full.
+static int
+pageout_queue(void **pa, int slot, int n)
+{
+  int r;
+
+  acquire(&pageout.lock);
+  if(pageout.n == NPAGEOUT){
+    release(&pageout.lock);
+    return -1;
+  }
+  if(!pageout.started){
+    pageout.started = 1;
+    release(&pageout.lock);
+    kthread_create(pageoutd, "pageoutd");
+    acquire(&pageout.lock);
+  }
+  r = (pageout.head + pageout.n) % NPAGEOUT;
+  for(int i = 0; i < n; i++){
+    kdup(pa[i]);
+    swap_dup(slot + i);
+    pageout.inflight[slot + i] = 1;
+    pageout.req[r].pa[i] = pa[i];
+  }
+  pageout.req[r].slot = slot;
+  pageout.req[r].n = n;
+  pageout.n++;
+  wakeup(&pageout);
+  release(&pageout.lock);
+  return 0;
+}
+
+// Called after p faults a page in. If fewer than PAGEOUT_LOW
+// of p's frames are free or already cleaned, hand victims to
+// pageoutd until PAGEOUT_HIGH are.
+void
+preclean(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  struct memory_page_entry *victim[SWAPCLUSTER];
+  void *pa[SWAPCLUSTER];
+  int ready, index, slot, n, i;
+  pte_t *pte;
+
+  if(p->pid <= 2 || (p->name[0] == 's' && p->name[1] == 'h' && p->name[3]=='\000'))
+    return;
+  ready = pmd->mem.limit - pmd->mem.n;
+  for_each_entry(i, &pmd->mem){
+    if(MPE(pmd, i)->cleaned)
+      ready++;
+  }
+  if(ready >= PAGEOUT_LOW)
+    return;
+
+  // pick the victims, marking each cleaned so that
+  // index_to_swap() moves on to the next one.
+  for(n = 0; n < SWAPCLUSTER && ready + n < PAGEOUT_HIGH; n++){
+    if((index = index_to_swap(p)) < 0)
+      break;
+    victim[n] = MPE(pmd, index);
+    pte = walk(p->pagetable, victim[n]->va, 0);
+    if(pte == 0 || (*pte & PTE_V) == 0)
+      break;
+    victim[n]->cleaned = 1;
+  }
+  if(n == 0)
+    return;
+
+  if((slot = swap_alloc_cluster(n)) < 0){
+    // no contiguous run left; clean just one page.
+    for(i = 1; i < n; i++)
+      victim[i]->cleaned = 0;
+    n = 1;
+    if((slot = swap_alloc()) < 0){
+      victim[0]->cleaned = 0;
+      return;
+    }
+  }
+
+  // the copies must not miss stores that are still
+  // allowed by a stale dirty TLB entry.
+  for(i = 0; i < n; i++){
+    pte = walk(p->pagetable, victim[i]->va, 0);
+    *pte &= ~PTE_D;
+    pa[i] = (void*)PTE2PA(*pte);
+    uvmflush(p->pagetable, victim[i]->va, 1);
+  }
+  if(pageout_queue(pa, slot, n) < 0){
+    for(i = 0; i < n; i++){
+      swap_free(slot + i);
+      victim[i]->cleaned = 0;
+    }
+    return;
+  }
+  for(i = 0; i < n; i++)
+    victim[i]->slot = slot + i;
+  PGSTAT_ADD(p, bytesout, n*PGSIZE);
+}
+
+// Global reclaim. Each process reports its cold pages, those
+// outside its working set, whenever ws_update() estimates it;
+// coldpages is their sum. When free memory falls below
+// RECLAIMLOW pages, each process gives back its share of the
+// pages needed to get to RECLAIMHIGH, in proportion to its cold
+// pages, at its next aging pass. Eviction picks the coldest
+// pages first, as usual, so processes with large working sets
+// and few cold pages are left mostly alone.
+static int coldpages;
+
+// Record that p has cold resident pages.
+void
+reclaim_setcold(struct proc *p, int cold)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+
+  __sync_fetch_and_add(&coldpages, cold - pmd->cold);
+  pmd->cold = cold;
+}
+
+// Trim p if memory is short, from its aging pass.
+void
+reclaim_tick(struct proc *p)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int free = kfreepages();
+  int total = coldpages;
+  int n, i;
+
+  if(free >= RECLAIMLOW || pmd->cold <= 0 || total <= 0)
+    return;
+  n = (pmd->cold * (RECLAIMHIGH - free) + total - 1) / total;
+  if(n > pmd->cold)
+    n = pmd->cold;
+  if(n > RECLAIMBATCH)
+    n = RECLAIMBATCH;
+  for(i = 0; i < n && pmd->swap.n < pmd->swap.limit; i++){
+    if(swap_out_memory(p) < 0)
+      break;
+  }
+  PGSTAT_ADD(p, reclaimed, i);
+  reclaim_setcold(p, pmd->cold - i);
+}
+
+// The range of p given MADV_RANDOM or MADV_SEQUENTIAL that
+// holds va, or 0.
+struct madvrange*
+madv_find(struct proc *p, uint64 va)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+
+  for(int i = 0; i < pmd->nmadv; i++){
+    if(va >= pmd->madv[i].start && va < pmd->madv[i].end)
+      return &pmd->madv[i];
+  }
+  return 0;
+}
+
+// Note that p faulted in the page at va.
+static void
+madv_touch(struct proc *p, uint64 va)
+{
+  struct madvrange *r = madv_find(p, va);
+
+  if(r)
+    r->last = va;
 }
 
 int add_to_memory(struct proc *p,uint64 a){
   //printf("add_to_memory: a=%d\n", a);
   struct paging_metadata *pmd =&p->paging_metadata;
   //print_memory(p);
-  if(pmd->num_in_memory == MAX_PSYC_PAGES){ //memory is full
+  if(pmd->mem.n >= pmd->mem.limit){ //memory is full
     if(swap_out_memory(p)==-1){ //swap out file from memory
       printf("add_to_memory: swap_out failed\n");
       return -1;
     }
   }
-  //find empty entry in memory
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    struct memory_page_entry *mpe = &pmd->memory_page_entries[i];
-    if(mpe->present == 0){
-      mpe->present =1;
-      mpe->va = a;
-      mpe->offset = i;
-      pmd->num_in_memory++;
-      #ifdef NFUA
-      mpe->age = 0;
-      #endif
-      #ifdef LAPA
-      mpe->age = 0xFFFFFFFF;
-      #endif
-      #ifdef SCFIFO
-      mpe->order = pmd->order_counter;
-      pmd->order_counter++;
-      #endif
-
-      break;
-    }
+  int i = pgindex_add(&pmd->mem, a);
+  if(i < 0){
+    printf("add_to_memory: out of memory\n");
+    return -1;
   }
+  struct memory_page_entry *mpe = MPE(pmd, i);
+  mpe->present =1;
+  mpe->offset = i;
+  policy_add(p, mpe);
+  madv_touch(p, a);
+
   // set the flags
   pte_t *pte = walk(p->pagetable, a, 0);
   *pte &= ~PTE_PG; //clear PTE_PG - not in swap file 0
@@ -565,51 +1113,93 @@ int swap_out_memory(struct proc *p){ //swap in to the swap file
   print_swap_file(p);
   #endif
   struct paging_metadata *pmd =&p->paging_metadata;
-  if(pmd->num_in_swap+ pmd->num_in_memory == MAX_TOTAL_PAGES){ //swap file is full
-    panic("more than 32 pages per proccess\n");
-  }
-  int index= index_to_swap(p);
-  struct memory_page_entry *mpe_to_swap = &pmd->memory_page_entries[index];
-
-  //find empty entry in swap file
-  for(int i=0; i< MAX_TOTAL_PAGES-MAX_PSYC_PAGES; i++){
-    struct swap_file_entry *sfe = &pmd->swap_file_entries[i];
-    if(sfe->present == 0){
-      sfe->present =1;
-      sfe->va = mpe_to_swap->va;
-      sfe->offset = i;
-      
-      pte_t *pte = walk(p->pagetable, mpe_to_swap->va, 0);
-      uint64 pa = PTE2PA(*pte);
-      if(writeToSwapFile(p, (char*)pa, i*PGSIZE, PGSIZE)!=PGSIZE){
-        printf("swap_out_memory: writeToSwapFile failed\n");
-        return -1;
-      }
-      kfree((void*)pa);
-      *pte &= ~PTE_V; //clear PTE_V - not in memory 0
-      *pte |= PTE_PG; //set PTE_PG - in swap file 1
-      mpe_to_swap->present = 0;
-      mpe_to_swap->age = 0;
-      mpe_to_swap->offset = 0;
-      mpe_to_swap->va = 0;
-      mpe_to_swap->order = 0;
-
-      pmd->num_in_swap++;
-      pmd->num_in_memory--;
-      sfence_vma();
-      #ifdef YES
-      printf("swap_out_memory: finished\n");
-      printf("memory after swap out:\n");
-      print_memory(p);
-      printf("swap file after swap out:\n");
-      print_swap_file(p);
-      #endif
-      return 0;
+  if(pmd->swap.n >= pmd->swap.limit){ //swap file is full
+    panic("too many pages per proccess\n");
+  }
+  int index= index_to_evict(p);
+  if(index < 0)
+    return -1;
+  struct memory_page_entry *mpe_to_swap = MPE(pmd, index);
+
+  int i = pgindex_add(&pmd->swap, mpe_to_swap->va);
+  if(i < 0){
+    printf("swap_out_memory: out of memory\n");
+    return -1;
+  }
+  pte_t *pte = walk(p->pagetable, mpe_to_swap->va, 0);
+  uint64 pa = PTE2PA(*pte);
+  int slot = -1;
+  if(pa == (uint64)ksm_zeropage() && zerolazy(p, mpe_to_swap->va, *pte)){
+    // nothing to write out: make it untouched again.
+    if(mpe_to_swap->cleaned)
+      swap_free(mpe_to_swap->slot);
+    pgindex_remove(&pmd->swap, i);
+    *pte = 0;
+    uvmflush(p->pagetable, mpe_to_swap->va, 1);
+    kfree((void*)pa);
+    policy_evict(p, mpe_to_swap);
+    pgindex_remove(&pmd->mem, index);
+    return 0;
+  }
+  if(mpe_to_swap->cleaned){
+    // reuse pageoutd's copy unless the page was written since.
+    slot = mpe_to_swap->slot;
+    pageout_wait(slot);
+    if(*pte & PTE_D){
+      swap_free(slot);
+      slot = -1;
     }
   }
-  
+  if(slot < 0){
+    if((slot = swap_alloc()) < 0){
+      printf("swap_out_memory: swap area full\n");
+      mpe_to_swap->cleaned = 0;
+      pgindex_remove(&pmd->swap, i);
+      return -1;
+    }
+    swap_write(slot, (void*)pa);
+    PGSTAT_ADD(p, bytesout, PGSIZE);
+  }
+  struct swap_file_entry *sfe = SFE(pmd, i);
+  sfe->present =1;
+  sfe->offset = slot;
+  kfree((void*)pa);
+  PGSTAT_ADD(p, swapouts, 1);
+  *pte &= ~PTE_V; //clear PTE_V - not in memory 0
+  *pte |= PTE_PG; //set PTE_PG - in swap file 1
+  uvmflush(p->pagetable, mpe_to_swap->va, 1);
+  policy_evict(p, mpe_to_swap);
+  pgindex_remove(&pmd->mem, index);
+  #ifdef YES
+  printf("swap_out_memory: finished\n");
+  printf("memory after swap out:\n");
+  print_memory(p);
+  printf("swap file after swap out:\n");
+  print_swap_file(p);
+  #endif
+  return 0;
+}
 
-  return -1;
+// Read the swapped-out pages that follow va in p's address
+// space, up to window of them, into the swap cache. If slot is
+// not -1 the faulting page is read along with them, so that
+// one request serves both when their slots are contiguous.
+static void
+swap_in_readahead(struct proc *p, uint64 va, int slot, int window)
+{
+  struct paging_metadata *pmd =&p->paging_metadata;
+  int slots[1+SWAPCLUSTER];
+  int n = 0;
+
+  if(slot >= 0)
+    slots[n++] = slot;
+  for(int d = 1; d <= window; d++){
+    int i = pgindex_find(&pmd->swap, va + d*PGSIZE);
+    if(i >= 0)
+      slots[n++] = SFE(pmd, i)->offset;
+  }
+  if(n > 0)
+    swap_readahead(slots, n);
 }
 
 int swap_in_memory(struct proc *p, uint64 address){
@@ -622,59 +1212,81 @@ int swap_in_memory(struct proc *p, uint64 address){
   pte_t *pte = walk(p->pagetable, va1, 0); 
   if((*pte & PTE_PG)){ //is in swap file
     struct paging_metadata *pmd =&p->paging_metadata;
-    if(pmd->num_in_memory == MAX_PSYC_PAGES){ //memory is full
+    // find the address in the swap file and remove it from the struct
+    int i = pgindex_find(&pmd->swap, va1);
+    if(i < 0){
+      printf("swap_in_memory: no slot\n");
+      return -1;
+    }
+    // remove it first, so that its entry is free for the
+    // page that goes out to make room.
+    int slot = SFE(pmd, i)->offset;
+    pgindex_remove(&pmd->swap, i);
+    if(pmd->mem.n >= pmd->mem.limit){ //memory is full
       if(swap_out_memory(p)==-1){ //swap out file from memory
         printf("swap_in_memory: swap_out failed\n");
+        // put it back; the entry just removed is still free.
+        i = pgindex_add(&pmd->swap, va1);
+        SFE(pmd, i)->present = 1;
+        SFE(pmd, i)->offset = slot;
         return -1;
       }
     }
-    // find the address in the swap file and remove it from the struct
-    struct swap_file_entry *sfe;
-    int offset=0;
-    for(int i=0; i< MAX_TOTAL_PAGES-MAX_PSYC_PAGES; i++){
-      sfe = &pmd->swap_file_entries[i];
-      if(sfe->va == va1 && sfe->present == 1){
-        offset = i;
-        sfe->present = 0;
-        sfe->va = 0;
-        sfe->offset = 0;
-        pmd->num_in_swap--;
-        break;
-      }
+    // fill in a memory entry for it
+    if((i = pgindex_add(&pmd->mem, va1)) < 0){
+      printf("swap_in_memory: out of memory\n");
+      return -1;
     }
-    // find empty entry in memory and fill it in the struct
-    struct memory_page_entry *mpe;
-    for(int i=0; i< MAX_PSYC_PAGES; i++){
-      mpe = &pmd->memory_page_entries[i];
-      if(mpe->present == 0){
-        mpe->present =1;
-        mpe->va = va1;
-        mpe->offset = i;
-        pmd->num_in_memory++;
-        #ifdef NFUA
-        mpe->age = 0;
-        #endif
-        #ifdef LAPA
-        mpe->age = 0xFFFFFFFF;
-        #endif
-        #ifdef SCFIFO
-        mpe->order = pmd->order_counter;
-        pmd->order_counter++;
-        #endif
-        break;
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    mpe->present =1;
+    mpe->offset = i;
+    policy_add(p, mpe);
+    char *pa = swap_cache_take(slot);
+    if(pa){
+      PGSTAT_ADD(p, rahits, 1);
+      PGSTAT_ADD(p, minfaults, 1);
+      pmd->ra_window = pmd->ra_window ? pmd->ra_window*2 : 1;
+      if(pmd->ra_window > SWAPCLUSTER)
+        pmd->ra_window = SWAPCLUSTER;
+    } else if(zswap_has(slot)){
+      // swap_read() will find it in the compressed pool.
+      PGSTAT_ADD(p, minfaults, 1);
+    } else {
+      PGSTAT_ADD(p, ramisses, 1);
+      PGSTAT_ADD(p, majfaults, 1);
+      if(va1 == pmd->ra_last + PGSIZE){
+        if(pmd->ra_window == 0)
+          pmd->ra_window = 1;
+      } else {
+        pmd->ra_window /= 2;
       }
     }
-    // read from swap file to memory
-    char* pa = kalloc();
-    if(readFromSwapFile(p, pa, offset*PGSIZE, PGSIZE)!=PGSIZE){
-      printf("swap_in_memory: readFromSwapFile failed\n");
-      return -1;
+    pmd->ra_last = va1;
+    // madvise() overrides the adaptive window.
+    struct madvrange *r = madv_find(p, va1);
+    int window = pmd->ra_window;
+    if(r && r->advice == MADV_SEQUENTIAL)
+      window = SWAPCLUSTER;
+    else if(r && r->advice == MADV_RANDOM)
+      window = 0;
+    madv_touch(p, va1);
+    swap_in_readahead(p, va1, pa ? -1 : slot, window);
+    if(pa == 0 && (pa = swap_cache_take(slot)) == 0){
+      if((pa = kalloc()) == 0){
+        printf("swap_in_memory: out of memory\n");
+        return -1;
+      }
+      swap_read(slot, pa);
     }
+    // the page is now private to p; a process that still
+    // shares the slot keeps reading its own copy from there.
+    swap_free(slot);
+    PGSTAT_ADD(p, swapins, 1);
     //map the new address in the memory and set the flags
     *pte = PA2PTE((uint64)pa) | PTE_FLAGS(*pte);
     *pte &= ~PTE_PG; //clear PTE_PG - not in swap file 0
     *pte |= PTE_V; //set PTE_V - in memory 1
-    sfence_vma();
+    uvmflush(p->pagetable, va1, 1);
     return 0;
   }
   else{
@@ -683,152 +1295,156 @@ int swap_in_memory(struct proc *p, uint64 address){
   }
 }
 
-
-void print_memory(struct proc *p){
-  printf("--------printing memory----------\n");
+// Let the current process keep up to resident pages in memory
+// and swapped pages in swap, evicting pages if it has more
+// resident ones than that.
+int
+set_paging_limits(int resident, int swapped)
+{
+  struct proc *p = myproc();
   struct paging_metadata *pmd =&p->paging_metadata;
-  printf("num in memory: %d, num in swap file: %d\n", pmd->num_in_memory, pmd->num_in_swap);
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    struct memory_page_entry *mpe = &pmd->memory_page_entries[i];
-    printf("present: %d, va: %d , offset: %d, age:%d, order:%d\n",mpe->present, mpe->va,mpe->offset, mpe->age, mpe->order);
+
+  if(resident < 1 || swapped < 1 || resident + swapped > PGINDEX_MAX)
+    return -1;
+  if(pgindex_setlimit(&pmd->swap, swapped) < 0)
+    return -1;
+  while(pmd->mem.n > resident){
+    if(swap_out_memory(p) < 0)
+      return -1;
   }
-  printf("-------------------------\n");
+  return pgindex_setlimit(&pmd->mem, resident);
 }
 
-void print_swap_file(struct proc *p){
-  printf("--------printing swap file----------\n");
+// Start reading the swapped-out pages of p from va to va+len
+// into the swap cache, as many as it holds.
+static void
+willneed(struct proc *p, uint64 va, uint64 len)
+{
   struct paging_metadata *pmd =&p->paging_metadata;
-  printf("num in memory: %d, num in swap file: %d\n", pmd->num_in_memory, pmd->num_in_swap);
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    struct swap_file_entry *sfe = &pmd->swap_file_entries[i];
-    printf("present: %d, va: %d , offset: %d\n",sfe->present, sfe->va,sfe->offset);
+  int slots[NSWAPCACHE];
+  int n = 0, i;
+
+  for(uint64 a = va; a < va + len && n < NSWAPCACHE; a += PGSIZE){
+    if((i = pgindex_find(&pmd->swap, a)) >= 0)
+      slots[n++] = SFE(pmd, i)->offset;
   }
-  printf("-------------------------\n");
+  if(n > 0)
+    swap_readahead(slots, n);
 }
 
+// Free the pages of p from va to va+len, in memory or in
+// swap, leaving them untouched, to be faulted in afresh.
+static void
+dontneed(struct proc *p, uint64 va, uint64 len)
+{
+  pte_t *pte;
 
-int index_to_swap(struct proc *p){
-  #ifdef NFUA
-  return index_to_swap_NFUA(p);
-  #endif
-  #ifdef LAPA
-  return index_to_swap_LAPA(p);
-  #endif
-  #ifdef SCFIFO
-  return index_to_swap_SCFIFO(p);
-  #endif
-  panic("index_to_swap: no algorithm defined\n");
-}
-
-int index_to_swap_NFUA(struct proc *p){
-  struct paging_metadata *pmd =&p->paging_metadata;
-  uint min =pmd->memory_page_entries[0].age;
-  int index =0;
-  for(int i=1; i< MAX_PSYC_PAGES; i++){
-    struct memory_page_entry *mpe = &pmd->memory_page_entries[i];
-    if(mpe->present == 1 && mpe->age < min){
-      min = mpe->age;
-      index = i;
+  for(uint64 a = va; a < va + len; a += PGSIZE){
+    if((pte = walk(p->pagetable, a, 0)) == 0 || (*pte & PTE_U) == 0)
+      continue;
+    if(*pte & PTE_V){
+      remove_page_from_memory(p, a);
+      kfree((void*)PTE2PA(*pte));
+    } else if(*pte & PTE_PG){
+      remove_page_from_swapfile(p, a);
     }
+    *pte = 0;
   }
-  #ifdef YES
-  //print_memory(p);
-  printf("index_to_swap_NFUA: index: %d with age:%d\n", index, min);
-  #endif
-  return index;
+  uvmflush(p->pagetable, va, len / PGSIZE);
 }
 
-
-int index_to_swap_LAPA(struct proc *p){
-  //printf("index_to_swap_LAPA\n");
-  int index = 0;
+// Advise the kernel about the current process's use of the
+// page-aligned range from addr to addr+len. MADV_WILLNEED and
+// MADV_DONTNEED act on the range now; MADV_RANDOM and
+// MADV_SEQUENTIAL are remembered, replacing advice given
+// before for any range they overlap, and steer readahead in
+// swap_in_memory() and eviction in index_to_swap();
+// MADV_NORMAL forgets that advice.
+int
+madvise(uint64 addr, uint64 len, int advice)
+{
+  struct proc *p = myproc();
   struct paging_metadata *pmd =&p->paging_metadata;
-  int min_count = countSetBits(pmd->memory_page_entries[0].age);
-  for(int i=1; i< MAX_PSYC_PAGES; i++){
-    struct memory_page_entry *mpe = &pmd->memory_page_entries[i];
-    int count = countSetBits(mpe->age);
-    if(count < min_count){
-      min_count = count;
-      index = i;
-    }
-    else if(count == min_count){
-      if(mpe->age < pmd->memory_page_entries[index].age){
-        index = i;
-      }
-    }
+  uint64 end = PGROUNDUP(addr + len);
+  int i;
+
+  if(addr % PGSIZE || len == 0 || end < addr || end > p->sz)
+    return -1;
+  switch(advice){
+  case MADV_WILLNEED:
+    willneed(p, addr, end - addr);
+    return 0;
+  case MADV_DONTNEED:
+    dontneed(p, addr, end - addr);
+    return 0;
+  case MADV_NORMAL:
+  case MADV_RANDOM:
+  case MADV_SEQUENTIAL:
+    break;
+  default:
+    return -1;
   }
-  #ifdef YES
-  //print_memory(p);
-  printf("index_to_swap_LAPA: index: %d with min count:%d\n", index, min_count);
-  #endif
-  return index;
-}
 
-int countSetBits(uint n)
-{
-    int count = 0;
-    while (n) {
-        count += n & 1;
-        n >>= 1;
-    }
-    return count;
+  for(i = 0; i < pmd->nmadv; ){
+    if(pmd->madv[i].start < end && addr < pmd->madv[i].end)
+      pmd->madv[i] = pmd->madv[--pmd->nmadv];
+    else
+      i++;
+  }
+  if(advice == MADV_NORMAL)
+    return 0;
+  if(pmd->nmadv == NMADV)
+    return -1;
+  pmd->madv[pmd->nmadv].start = addr;
+  pmd->madv[pmd->nmadv].end = end;
+  pmd->madv[pmd->nmadv].advice = advice;
+  pmd->madv[pmd->nmadv].last = addr;
+  pmd->nmadv++;
+  return 0;
 }
 
-int index_to_swap_SCFIFO(struct proc *p){
-  int index = find_min_order(p);
+
+void print_memory(struct proc *p){
+  printf("--------printing memory----------\n");
   struct paging_metadata *pmd =&p->paging_metadata;
-  int bool = 0;
-  while(bool==0){
-    struct memory_page_entry *found_mpe = &pmd->memory_page_entries[index];
-    pte_t* pte = walk(p->pagetable,found_mpe->va,0);
-    if((*pte & PTE_A)!=0) { //access flag is on
-      *pte &=~ PTE_A; //trun off the access flag
-      found_mpe->order= pmd->order_counter; //gets new order
-      pmd->order_counter++;
-      #ifdef YES
-      printf("index_to_swap_SCFIFO: index: %d with new order:%d\n", index, found_mpe->order);
-      #endif
-      index = find_min_order(p);
-    }
-    else{
-      bool = 1;
-    }
+  printf("num in memory: %d, num in swap file: %d\n", pmd->mem.n, pmd->swap.n);
+  int i;
+  for_each_entry(i, &pmd->mem){
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    printf("present: %d, va: %d , offset: %d, age:%d, order:%d\n",mpe->present, mpe->va,mpe->offset, mpe->age, mpe->order);
   }
-  #ifdef YES
-  printf("the final index_to_swap_SCFIFO: index: %d with order:%d\n", index, pmd->memory_page_entries[index].order);
-  #endif
-  return index;
+  printf("-------------------------\n");
 }
 
-int find_min_order(struct proc *p){
-  int index= -1;
-  int min_order = __INT_MAX__;
+void print_swap_file(struct proc *p){
+  printf("--------printing swap file----------\n");
   struct paging_metadata *pmd =&p->paging_metadata;
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    struct memory_page_entry *mpe = &pmd->memory_page_entries[i];
-    if(mpe->present == 1 && mpe->order < min_order){
-      min_order = mpe->order;
-      index = i;
-    }
+  printf("num in memory: %d, num in swap file: %d\n", pmd->mem.n, pmd->swap.n);
+  int i;
+  for_each_entry(i, &pmd->swap){
+    struct swap_file_entry *sfe = SFE(pmd, i);
+    printf("present: %d, va: %d , offset: %d\n",sfe->present, sfe->va,sfe->offset);
   }
-  #ifdef YES
-  printf("find_min_order: index: %d with order:%d\n", index, min_order);
-  #endif
-  return index;
-
+  printf("-------------------------\n");
 }
 
-void update_age(struct proc *p){
+
+// Pick the resident page to evict: one already cleaned by
+// pageoutd if there is one, preferring pages not written since,
+// otherwise whatever the replacement policy chooses.
+int index_to_evict(struct proc *p){
   struct paging_metadata *pmd =&p->paging_metadata;
-  for(int i=0; i< MAX_PSYC_PAGES; i++){
-    struct memory_page_entry *mpe = &pmd->memory_page_entries[i];
-    if(mpe->present == 1){
+  int index = -1, i;
+  for_each_entry(i, &pmd->mem){
+    struct memory_page_entry *mpe = MPE(pmd, i);
+    if(mpe->cleaned){
       pte_t *pte = walk(p->pagetable, mpe->va, 0);
-      mpe->age = (mpe->age >> 1); //shift right by one bit
-      if(*pte & PTE_A){ //if accessed
-        mpe->age |= 1 << 31; //add 1 to msb
-        *pte &= ~PTE_A; //reset PTE_A flag
-      }
+      if((*pte & PTE_D) == 0)
+        return i;
+      index = i;
     }
   }
-}
\ No newline at end of file
+  if(index >= 0)
+    return index;
+  return index_to_swap(p);
+}
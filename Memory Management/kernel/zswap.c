@@ -0,0 +1,291 @@
+// Compressed swap pool.
+//
+// A page written to a swap slot is first compressed into a
+// bounded pool in memory, keyed by the slot; reading the slot
+// back then decompresses it instead of going to disk. Only pages
+// that do not compress to half a page or less, or that do not
+// fit in the pool's NZSWAPPAGES pages, reach the swap area. The
+// slot is allocated either way, so it can always be written out
+// and the swap code above keeps its one notion of where a page
+// lives. A slot's contents never change while it is allocated,
+// so its compressed copy stays valid until swap_free() drops it.
+//
+// Compressed pages are kept in slab caches of a few size classes,
+// chosen so that a whole number of objects fill a slab page.
+//
+// The compressor is a small LZ77: a hash of the next four bytes
+// finds the last position that started with the same hash, and a
+// match of at least ZMINMATCH bytes there is coded as a length
+// and a distance back. The output is a sequence of
+//   0lllllll  followed by l+1 literal bytes, or
+//   1lllllll  d0 d1: copy l+ZMINMATCH bytes from d0|d1<<8 back.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "defs.h"
+#include "memstat.h"
+
+#define ZHASHBITS 10
+#define ZMINMATCH 4
+#define ZMAXMATCH (ZMINMATCH + 127)
+#define ZMAXLIT   128
+
+#define NZCLASS 6
+#define ZMAXSIZE 2032   // two to a slab page
+
+static struct {
+  int size;
+  char *name;
+} zclass[NZCLASS] = {
+  { 120,  "zswap-120" },
+  { 248,  "zswap-248" },
+  { 504,  "zswap-504" },
+  { 1016, "zswap-1016" },
+  { 1352, "zswap-1352" },
+  { ZMAXSIZE, "zswap-2032" },
+};
+
+struct {
+  struct spinlock lock;
+  struct kmem_cache *cache[NZCLASS];
+  struct {
+    void *data;          // 0 if the slot is not in the pool
+    ushort len;
+    uchar cls;
+  } ent[NSWAPPAGES];
+  short htab[1 << ZHASHBITS];   // compressor state, under lock
+  uchar buf[ZMAXSIZE];
+  struct memstat st;     // only the z fields are used
+} zswap;
+
+void
+zswapinit(void)
+{
+  initlock(&zswap.lock, "zswap");
+  for(int c = 0; c < NZCLASS; c++)
+    zswap.cache[c] = kmem_cache_create(zclass[c].name, zclass[c].size);
+}
+
+static uint
+zhash(uchar *s)
+{
+  uint v = s[0] | s[1] << 8 | s[2] << 16 | (uint)s[3] << 24;
+  return (v * 2654435761U) >> (32 - ZHASHBITS);
+}
+
+// Append a run of lit literal bytes from s to dst at o.
+// Returns the new length, or -1 if it passes max.
+static int
+putlit(uchar *dst, int o, int max, uchar *s, int lit)
+{
+  if(lit == 0)
+    return o;
+  if(o + 1 + lit > max)
+    return -1;
+  dst[o++] = lit - 1;
+  memmove(dst + o, s, lit);
+  return o + lit;
+}
+
+// Compress n bytes at src into dst, which has room for max.
+// Returns the compressed length, or -1 if it does not fit.
+static int
+lz_compress(uchar *src, int n, uchar *dst, int max)
+{
+  int i = 0, o = 0, lit = 0, m, cand = 0;
+  uint h;
+
+  for(h = 0; h < (1 << ZHASHBITS); h++)
+    zswap.htab[h] = -1;
+  while(i < n){
+    m = 0;
+    if(i + ZMINMATCH <= n){
+      h = zhash(src + i);
+      cand = zswap.htab[h];
+      zswap.htab[h] = i;
+      if(cand >= 0 && memcmp(src + cand, src + i, ZMINMATCH) == 0){
+        m = ZMINMATCH;
+        while(i + m < n && m < ZMAXMATCH && src[cand+m] == src[i+m])
+          m++;
+      }
+    }
+    if(m == 0){
+      i++;
+      if(++lit == ZMAXLIT){
+        if((o = putlit(dst, o, max, src + i - lit, lit)) < 0)
+          return -1;
+        lit = 0;
+      }
+      continue;
+    }
+    if((o = putlit(dst, o, max, src + i - lit, lit)) < 0 || o + 3 > max)
+      return -1;
+    lit = 0;
+    dst[o++] = 0x80 | (m - ZMINMATCH);
+    dst[o++] = (i - cand) & 0xff;
+    dst[o++] = (i - cand) >> 8;
+    i += m;
+  }
+  return putlit(dst, o, max, src + i - lit, lit);
+}
+
+// Decompress n bytes at src into dst, which has room for max.
+// Returns the decompressed length, or -1 if src is corrupt.
+static int
+lz_decompress(uchar *src, int n, uchar *dst, int max)
+{
+  int i = 0, o = 0, len, d;
+
+  while(i < n){
+    int c = src[i++];
+    if(c & 0x80){
+      len = (c & 0x7f) + ZMINMATCH;
+      if(i + 2 > n)
+        return -1;
+      d = src[i] | src[i+1] << 8;
+      i += 2;
+      if(d == 0 || d > o || o + len > max)
+        return -1;
+      for(; len > 0; len--, o++)
+        dst[o] = dst[o - d];   // may overlap, byte by byte
+    } else {
+      len = c + 1;
+      if(i + len > n || o + len > max)
+        return -1;
+      memmove(dst + o, src + i, len);
+      i += len;
+      o += len;
+    }
+  }
+  return o;
+}
+
+// Drop slot's entry. Caller holds zswap.lock.
+static void
+zdrop(int slot)
+{
+  int c = zswap.ent[slot].cls;
+
+  if(zswap.ent[slot].data == 0)
+    return;
+  kmem_cache_free(zswap.cache[c], zswap.ent[slot].data);
+  zswap.ent[slot].data = 0;
+  zswap.st.zpoolbytes -= zclass[c].size;
+  zswap.st.zpages--;
+}
+
+// Compress the page pa into the pool as the contents of slot.
+// Returns 0, or -1 if it should be written to disk instead.
+int
+zswap_store(int slot, void *pa)
+{
+  int n, c;
+  void *data;
+
+  if(slot < 0 || slot >= NSWAPPAGES)
+    panic("zswap_store");
+  acquire(&zswap.lock);
+  zdrop(slot);
+  n = lz_compress(pa, PGSIZE, zswap.buf, ZMAXSIZE);
+  for(c = 0; n >= 0 && zclass[c].size < n; c++)
+    ;
+  if(n < 0 || zswap.st.zpoolbytes + zclass[c].size > NZSWAPPAGES*PGSIZE ||
+     (data = kmem_cache_alloc(zswap.cache[c])) == 0){
+    zswap.st.zrejects++;
+    release(&zswap.lock);
+    return -1;
+  }
+  memmove(data, zswap.buf, n);
+  zswap.ent[slot].data = data;
+  zswap.ent[slot].len = n;
+  zswap.ent[slot].cls = c;
+  zswap.st.zpoolbytes += zclass[c].size;
+  zswap.st.zpages++;
+  zswap.st.zstores++;
+  zswap.st.zbytesin += PGSIZE;
+  zswap.st.zbytesout += n;
+  release(&zswap.lock);
+  return 0;
+}
+
+// If slot is in the pool, decompress it into the page pa and
+// return 0. Otherwise return -1; the caller reads it from disk.
+int
+zswap_load(int slot, void *pa)
+{
+  acquire(&zswap.lock);
+  if(zswap.ent[slot].data == 0){
+    zswap.st.zmisses++;
+    release(&zswap.lock);
+    return -1;
+  }
+  if(lz_decompress(zswap.ent[slot].data, zswap.ent[slot].len, pa, PGSIZE) != PGSIZE)
+    panic("zswap_load");
+  zswap.st.zhits++;
+  release(&zswap.lock);
+  return 0;
+}
+
+// Is slot in the pool?
+int
+zswap_has(int slot)
+{
+  int r;
+
+  acquire(&zswap.lock);
+  r = zswap.ent[slot].data != 0;
+  release(&zswap.lock);
+  return r;
+}
+
+// Forget slot, which is being freed.
+void
+zswap_drop(int slot)
+{
+  acquire(&zswap.lock);
+  zdrop(slot);
+  release(&zswap.lock);
+}
+
+// Take back the zswap_store() of slot, whose page went to disk
+// after all, along with the counts it added.
+void
+zswap_unstore(int slot)
+{
+  acquire(&zswap.lock);
+  if(zswap.ent[slot].data){
+    zswap.st.zstores--;
+    zswap.st.zbytesin -= PGSIZE;
+    zswap.st.zbytesout -= zswap.ent[slot].len;
+    zdrop(slot);
+  }
+  release(&zswap.lock);
+}
+
+// Count n pages read from disk, for the hit rate.
+void
+zswap_miss(int n)
+{
+  acquire(&zswap.lock);
+  zswap.st.zmisses += n;
+  release(&zswap.lock);
+}
+
+// Copy the pool's counters into st.
+void
+zswap_stat(struct memstat *st)
+{
+  acquire(&zswap.lock);
+  st->zpoolbytes = zswap.st.zpoolbytes;
+  st->zpages = zswap.st.zpages;
+  st->zstores = zswap.st.zstores;
+  st->zrejects = zswap.st.zrejects;
+  st->zhits = zswap.st.zhits;
+  st->zmisses = zswap.st.zmisses;
+  st->zbytesin = zswap.st.zbytesin;
+  st->zbytesout = zswap.st.zbytesout;
+  release(&zswap.lock);
+}
@@ -0,0 +1,51 @@
+#include "kernel/types.h"
+#include "kernel/pgstat.h"
+#include "user/user.h"
+
+#define PGSIZE 4096
+#define RESIDENT 128   // pages kept in memory
+#define SWAPPED 768    // pages allowed in swap
+#define NPAGES 800     // heap pages
+
+// Large-heap test for the page index.
+// Raises the paging limits well past MAX_PSYC_PAGES, fills an
+// NPAGES heap, then checks every page twice, once in order and
+// once in reverse, and prints the faults and time taken.
+int
+main(int argc, char *argv[])
+{
+  struct pgstat before, after;
+
+  if(set_paging_limits(RESIDENT, SWAPPED) < 0){
+    printf("bigheap: set_paging_limits failed\n");
+    exit(1);
+  }
+  char *a = sbrk(NPAGES * PGSIZE);
+  if(a == (char*)-1){
+    printf("bigheap: sbrk failed\n");
+    exit(1);
+  }
+  getpgstat(getpid(), &before);
+  int start = uptime();
+  for(int i = 0; i < NPAGES; i++)
+    *(int*)(a + i * PGSIZE) = i;
+  for(int i = 0; i < NPAGES; i++){
+    if(*(int*)(a + i * PGSIZE) != i){
+      printf("bigheap: page %d lost its data\n", i);
+      exit(1);
+    }
+  }
+  for(int i = NPAGES - 1; i >= 0; i--){
+    if(*(int*)(a + i * PGSIZE) != i){
+      printf("bigheap: page %d lost its data\n", i);
+      exit(1);
+    }
+  }
+  getpgstat(getpid(), &after);
+  printf("bigheap: %d pages, %d resident: %d faults, %d swap-outs, %d swap-ins, %d ticks\n",
+         NPAGES, RESIDENT, after.faults - before.faults,
+         after.swapouts - before.swapouts, after.swapins - before.swapins,
+         uptime() - start);
+  printf("bigheap: OK\n");
+  exit(0);
+}
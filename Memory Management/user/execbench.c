@@ -0,0 +1,58 @@
+#include "kernel/types.h"
+#include "kernel/pgstat.h"
+#include "kernel/fcntl.h"
+#include "user/user.h"
+
+#define NEXEC 100
+
+// initialized, so its pages come from this program's file.
+char data[3*4096] = { 1 };
+
+// Exec latency benchmark.
+// Runs "execbench -" NEXEC times, which exits as soon as it
+// starts, then prints the time per exec and the page faults
+// each one took to get that far. Pages of a program are now
+// read in on first touch, so both should scale with the pages
+// a program uses rather than with its size. Also checks that
+// the running program can't be opened for writing or truncated,
+// and that it can read itself into pages of its own not yet
+// read in.
+int
+main(int argc, char *argv[])
+{
+  struct pgstat before, after;
+  char *args[] = { "execbench", "-", 0 };
+
+  if(argc > 1)
+    exit(0);
+  if(open(args[0], O_WRONLY) >= 0 || open(args[0], O_RDONLY|O_TRUNC) >= 0){
+    printf("execbench: opened the running program for writing\n");
+    exit(1);
+  }
+  int fd = open(args[0], O_RDONLY);
+  if(fd < 0 || read(fd, data, sizeof(data)) != sizeof(data)){
+    printf("execbench: reading the program into itself failed\n");
+    exit(1);
+  }
+  close(fd);
+  getpgstat(0, &before);
+  int start = uptime();
+  for(int i = 0; i < NEXEC; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf("execbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      exec(args[0], args);
+      printf("execbench: exec failed\n");
+      exit(1);
+    }
+    wait(0);
+  }
+  int ticks = uptime() - start;
+  getpgstat(0, &after);
+  printf("%d execs: %d ticks, %d faults per exec\n", NEXEC, ticks,
+         (after.faults - before.faults) / NEXEC);
+  exit(0);
+}
@@ -0,0 +1,105 @@
+#include "kernel/types.h"
+#include "kernel/pgstat.h"
+#include "user/user.h"
+
+#define PGSIZE 4096
+#define NROUNDS 40     // sweeps over the heap per run
+
+// Page-fault throughput benchmark.
+// Each run takes as many faults of one kind as it can and prints
+// how many it took and how long they took:
+//   lazy  first touches of freshly sbrk()ed pages
+//   cow   writes to pages shared with a forked child
+//   swap  sweeps over a heap larger than the resident set
+// Run as "faultbench" for all kinds, or name one.
+
+char *kinds[] = { "lazy", "cow", "swap" };
+#define NKIND (sizeof(kinds)/sizeof(kinds[0]))
+
+// heap pages per kind; only MAX_PSYC_PAGES fit in memory, so
+// cow stays below that to take no swap faults.
+int npages[] = { 24, 12, 24 };
+
+static void
+fault(int kind, char *a, int round)
+{
+  int n = npages[kind];
+
+  switch(kind){
+  case 0:
+    a = sbrk(n * PGSIZE);
+    if(a == (char*)-1){
+      printf("faultbench: sbrk failed\n");
+      exit(1);
+    }
+    for(int i = 0; i < n; i++)
+      a[i * PGSIZE] = round;
+    sbrk(-n * PGSIZE);
+    break;
+  case 1: {
+    int pid = fork();
+    if(pid < 0){
+      printf("faultbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      sleep(1000);
+      exit(0);
+    }
+    for(int i = 0; i < n; i++)
+      a[i * PGSIZE] = round;
+    kill(pid);
+    wait(0);
+    break;
+  }
+  default:
+    for(int i = 0; i < n; i++)
+      a[i * PGSIZE] = round;
+  }
+}
+
+void
+run(int kind)
+{
+  struct pgstat before, after;
+  int pid = fork();
+
+  if(pid < 0){
+    printf("faultbench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    // lazy makes its own heap each round.
+    int n = kind == 0 ? 0 : npages[kind];
+    char *a = sbrk(n * PGSIZE);
+    if(a == (char*)-1){
+      printf("faultbench: sbrk failed\n");
+      exit(1);
+    }
+    for(int i = 0; i < n; i++)
+      a[i * PGSIZE] = 0;
+    getpgstat(getpid(), &before);
+    int start = uptime();
+    for(int r = 0; r < NROUNDS; r++)
+      fault(kind, a, r);
+    int ticks = uptime() - start;
+    getpgstat(getpid(), &after);
+    int faults = after.faults - before.faults;
+    printf("%s\t%d\t%d\t%d\n", kinds[kind], faults, ticks,
+           ticks ? faults / ticks : faults);
+    exit(0);
+  }
+  wait(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf("kind\tfaults\tticks\tper tick\n");
+  for(int k = 0; k < NKIND; k++){
+    if(argc > 1 && strcmp(argv[1], kinds[k]) != 0)
+      continue;
+    run(k);
+  }
+  exit(0);
+}
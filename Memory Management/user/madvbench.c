@@ -0,0 +1,129 @@
+#include "kernel/types.h"
+#include "kernel/pgstat.h"
+#include "kernel/madvise.h"
+#include "user/user.h"
+
+#define PGSIZE 4096
+#define NPAGES 64      // heap pages; only MAX_PSYC_PAGES fit in memory
+#define NACCESS 1000   // page touches in the random run
+
+// madvise() test and benchmark.
+// Runs each access pattern over an NPAGES heap twice, without
+// and with the matching advice, and prints the faults it took:
+//   seq       three sequential sweeps, MADV_SEQUENTIAL
+//   random    random pages, MADV_RANDOM
+//   willneed  a sweep over swapped-out pages, MADV_WILLNEED first
+// Then checks that MADV_DONTNEED pages come back zeroed.
+
+char *names[] = { "seq", "random", "willneed" };
+int advice[] = { MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED };
+
+static uint seed = 1;
+
+static uint
+rand(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) & 0x7fff;
+}
+
+static char*
+heap(void)
+{
+  char *a = sbrk(NPAGES * PGSIZE);
+  if(a == (char*)-1){
+    printf("madvbench: sbrk failed\n");
+    exit(1);
+  }
+  for(int i = 0; i < NPAGES; i++)
+    a[i * PGSIZE] = i;
+  return a;
+}
+
+static void
+touch(char *a, int pat)
+{
+  switch(pat){
+  case 0:
+    for(int n = 0; n < 3; n++)
+      for(int i = 0; i < NPAGES; i++)
+        a[i * PGSIZE]++;
+    break;
+  case 1:
+    for(int n = 0; n < NACCESS; n++)
+      a[(rand() % NPAGES) * PGSIZE]++;
+    break;
+  default:
+    for(int i = 0; i < NPAGES/4; i++)
+      a[i * PGSIZE]++;
+    break;
+  }
+}
+
+void
+run(int pat, int advise)
+{
+  struct pgstat before, after;
+  int pid;
+
+  pid = fork();
+  if(pid < 0){
+    printf("madvbench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    char *a = heap();
+    seed = 1;
+    getpgstat(getpid(), &before);
+    int start = uptime();
+    if(advise && madvise(a, NPAGES * PGSIZE, advice[pat]) < 0){
+      printf("madvbench: madvise failed\n");
+      exit(1);
+    }
+    touch(a, pat);
+    int ticks = uptime() - start;
+    getpgstat(getpid(), &after);
+    printf("%s\t%s\t%d\t%d\t%d\t%d\n", names[pat], advise ? "yes" : "no",
+           after.faults - before.faults,
+           after.majfaults - before.majfaults,
+           after.rahits - before.rahits,
+           ticks);
+    exit(0);
+  }
+  wait(0);
+}
+
+void
+dontneed(void)
+{
+  char *a = heap();
+
+  if(madvise(a, NPAGES * PGSIZE, MADV_DONTNEED) < 0){
+    printf("madvbench: madvise failed\n");
+    exit(1);
+  }
+  for(int i = 0; i < NPAGES; i++){
+    if(a[i * PGSIZE] != 0){
+      printf("madvbench: page %d kept its data\n", i);
+      exit(1);
+    }
+  }
+  if(madvise(a + 1, PGSIZE, MADV_DONTNEED) == 0 ||
+     madvise(a, PGSIZE, 99) == 0){
+    printf("madvbench: bad madvise accepted\n");
+    exit(1);
+  }
+  printf("madvbench: dontneed OK\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf("pattern\tadvice\tfaults\tmajor\trahits\tticks\n");
+  for(int pat = 0; pat < 3; pat++){
+    run(pat, 0);
+    run(pat, 1);
+  }
+  dontneed();
+  exit(0);
+}
@@ -0,0 +1,41 @@
+#include "kernel/types.h"
+#include "kernel/memstat.h"
+#include "user/user.h"
+
+// Print the physical memory allocator's counters: the free
+// blocks of each order, and how fragmented free memory is.
+// For each order, "unusable" is the part of free memory, per
+// 1000, that lies in blocks too small for a request of that
+// order. Then the compressed swap pool: how well pages
+// compressed, and the part of swap reads, per 1000, it served.
+// Last, the frames the zero page and same-page merging save.
+int
+main(int argc, char *argv[])
+{
+  struct memstat st;
+  uint64 above;
+
+  if(getmemstat(&st) < 0){
+    printf("memstat: getmemstat failed\n");
+    exit(1);
+  }
+  printf("%d of %d pages free, %d splits, %d merges\n",
+         (int)st.nfreepages, (int)st.npages, st.nsplit, st.nmerge);
+  printf("order\tfree\tallocs\tfails\tunusable\n");
+  for(int k = 0; k < MAXORDER; k++){
+    above = 0;
+    for(int j = k; j < MAXORDER; j++)
+      above += (uint64)st.nfree[j] << j;
+    printf("%d\t%d\t%d\t%d\t%d\n", k, st.nfree[k], st.nalloc[k], st.nfail[k],
+           st.nfreepages ? (int)(1000 - above * 1000 / st.nfreepages) : 0);
+  }
+  printf("zswap: %d pages in %d KB, %d stored, %d rejected\n",
+         st.zpages, (int)(st.zpoolbytes / 1024), st.zstores, st.zrejects);
+  printf("zswap: ratio %d/1000, %d hits, %d misses, hit rate %d/1000\n",
+         st.zbytesin ? (int)(st.zbytesout * 1000 / st.zbytesin) : 0,
+         st.zhits, st.zmisses,
+         st.zhits + st.zmisses ? st.zhits * 1000 / (st.zhits + st.zmisses) : 0);
+  printf("ksm: %d zero pages, %d scanned, %d merged, %d shared saving %d pages\n",
+         st.zeropages, st.ksmscanned, st.ksmmerged, st.ksmshared, st.ksmsaved);
+  exit(0);
+}
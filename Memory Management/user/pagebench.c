@@ -0,0 +1,136 @@
+#include "kernel/types.h"
+#include "kernel/pgstat.h"
+#include "kernel/swappolicy.h"
+#include "user/user.h"
+
+#define PGSIZE 4096
+#define NPAGES 24      // heap pages; only MAX_PSYC_PAGES fit in memory
+#define NACCESS 2000   // page touches per run
+
+// Replacement-policy benchmark.
+// Replays synthetic page access patterns over an NPAGES heap
+// under every policy and prints the faults each one caused:
+//   seq   repeated sequential sweeps over the whole heap
+//   loop  a loop over slightly more pages than fit in memory
+//   zipf  random pages, page k chosen with weight 1/k
+// Run as "pagebench" for all patterns, or name one.
+
+char *policies[NSWAPPOLICY] = {
+[SWAP_NFUA]   "nfua",
+[SWAP_LAPA]   "lapa",
+[SWAP_SCFIFO] "scfifo",
+[SWAP_CLOCK]  "clock",
+[SWAP_ARC]    "arc",
+};
+
+char *patterns[] = { "seq", "loop", "zipf" };
+#define NPATTERN (sizeof(patterns)/sizeof(patterns[0]))
+
+static uint seed = 1;
+
+static uint
+rand(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) & 0x7fff;
+}
+
+// cumulative weights of 1/k, k = 1..NPAGES, scaled to integers
+// since user programs cannot use floating point.
+static uint zipfcdf[NPAGES];
+
+static void
+zipfinit(void)
+{
+  uint sum = 0;
+
+  for(int k = 0; k < NPAGES; k++){
+    sum += 100000 / (k + 1);
+    zipfcdf[k] = sum;
+  }
+}
+
+static int
+zipf(void)
+{
+  uint r = ((rand() << 15) | rand()) % zipfcdf[NPAGES-1];
+
+  for(int k = 0; k < NPAGES; k++){
+    if(r < zipfcdf[k])
+      return k;
+  }
+  return NPAGES - 1;
+}
+
+// The i'th page touched by pattern pat.
+static int
+next(int pat, int i)
+{
+  switch(pat){
+  case 0:
+    return i % NPAGES;
+  case 1:
+    return i % 20;
+  default:
+    return zipf();
+  }
+}
+
+void
+run(int policy, int pat)
+{
+  struct pgstat before, after;
+  int pid;
+
+  pid = fork();
+  if(pid < 0){
+    printf("pagebench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    if(set_swap_policy(policy) < 0){
+      printf("pagebench: set_swap_policy failed\n");
+      exit(1);
+    }
+    char *a = sbrk(NPAGES * PGSIZE);
+    if(a == (char*)-1){
+      printf("pagebench: sbrk failed\n");
+      exit(1);
+    }
+    // fault everything in once, so that all policies
+    // start from the same resident set.
+    for(int i = 0; i < NPAGES; i++)
+      a[i * PGSIZE] = 0;
+    seed = 1;
+    getpgstat(getpid(), &before);
+    int start = uptime();
+    for(int i = 0; i < NACCESS; i++)
+      a[next(pat, i) * PGSIZE]++;
+    int ticks = uptime() - start;
+    getpgstat(getpid(), &after);
+    printf("%s\t%s\t%d\t%d\t%d\t%d\t%d\n", patterns[pat], policies[policy],
+           after.faults - before.faults,
+           after.majfaults - before.majfaults,
+           (after.faults - before.faults) * 1000 / NACCESS,
+           (int)((after.bytesout - before.bytesout) / 1024),
+           ticks);
+    exit(0);
+  }
+  wait(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  uint p;
+
+  zipfinit();
+  printf("pattern\tpolicy\tfaults\tmajor\tper1000\tKBout\tticks\n");
+  for(p = 0; p < NPATTERN; p++){
+    if(argc > 1 && strcmp(argv[1], patterns[p]) != 0)
+      continue;
+    for(int policy = 0; policy < NSWAPPOLICY; policy++)
+      run(policy, p);
+  }
+  exit(0);
+}
@@ -0,0 +1,65 @@
+#include "kernel/types.h"
+#include "kernel/memstat.h"
+#include "user/user.h"
+
+#define PGSIZE 4096
+#define NPAGES 64      // heap pages
+#define SPIN 20        // ticks to give the scanner
+
+// Zero page and same-page merging test.
+// Reads an untouched NPAGES heap, which should map the zero page
+// rather than allocate, then fills it with identical pages and
+// spins in user space, where the same-page scanner runs if the
+// kernel was built with KSM_INTERVAL. It checks that writing to
+// a shared page leaves the others alone, and prints the frames
+// each step saved.
+int
+main(int argc, char *argv[])
+{
+  struct memstat st0, st1, st2;
+  int sum = 0;
+
+  // keep the whole heap resident.
+  set_paging_limits(NPAGES + 16, 256);
+  char *a = sbrk(NPAGES * PGSIZE);
+  if(a == (char*)-1){
+    printf("samepage: sbrk failed\n");
+    exit(1);
+  }
+
+  getmemstat(&st0);
+  for(int i = 0; i < NPAGES; i++)
+    sum += a[i * PGSIZE];
+  getmemstat(&st1);
+  if(sum != 0){
+    printf("samepage: untouched page not zero\n");
+    exit(1);
+  }
+  printf("samepage: read %d untouched pages: %d map the zero page, %d fewer free pages\n",
+         NPAGES, st1.zeropages - st0.zeropages,
+         (int)(st0.nfreepages - st1.nfreepages));
+
+  for(int i = 0; i < NPAGES; i++)
+    for(int j = 0; j < PGSIZE; j += 512)
+      a[i * PGSIZE + j] = j / 512 + 1;
+  getmemstat(&st1);
+  int start = uptime();
+  while(uptime() - start < SPIN)
+    ;
+  getmemstat(&st2);
+  printf("samepage: %d identical pages: scanned %d, merged %d, %d shared saving %d frames\n",
+         NPAGES, st2.ksmscanned - st1.ksmscanned, st2.ksmmerged - st1.ksmmerged,
+         st2.ksmshared, st2.ksmsaved);
+
+  // each write must get a private copy.
+  for(int i = 0; i < NPAGES; i++)
+    a[i * PGSIZE] = i;
+  for(int i = 0; i < NPAGES; i++){
+    if(a[i * PGSIZE] != (char)i || a[i * PGSIZE + 512] != 2){
+      printf("samepage: page %d has the wrong data\n", i);
+      exit(1);
+    }
+  }
+  printf("samepage: OK\n");
+  exit(0);
+}
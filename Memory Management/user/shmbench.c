@@ -0,0 +1,171 @@
+#include "kernel/types.h"
+#include "kernel/memlayout.h"
+#include "user/user.h"
+
+#define PGSIZE 4096
+#define NPAGES 16                     // segment: a header page and the ring
+#define RING ((NPAGES - 1) * PGSIZE)
+#define CHUNK 512                     // bytes moved at a time, as pipes do
+#define TOTAL (8 * 1024 * 1024)       // bytes each run moves
+#define KEY 0x5348
+#define KEY2 0x5349
+
+// Shared memory test and benchmark.
+// A producer sends TOTAL bytes to a consumer, CHUNK bytes at a
+// time, first through a pipe, then through a ring buffer in a
+// shared memory segment that both have attached. Through the
+// pipe each byte is copied into the kernel and out again; in the
+// ring the producer writes it in place and the consumer reads it
+// there. The consumer checks every byte, and both runs print
+// the ticks they took. Last, it checks that a segment outlives
+// its last detach while an id got for it is still unattached.
+
+struct ring {
+  volatile uint head;   // bytes produced
+  volatile uint tail;   // bytes consumed
+};
+
+static char
+expect(uint pos)
+{
+  return pos + (pos >> 9);
+}
+
+static void
+fill(char *buf, uint pos)
+{
+  for(int i = 0; i < CHUNK; i++)
+    buf[i] = expect(pos + i);
+}
+
+static void
+check(char *buf, uint pos)
+{
+  for(int i = 0; i < CHUNK; i++){
+    if(buf[i] != expect(pos + i)){
+      printf("shmbench: byte %d is wrong\n", pos + i);
+      exit(1);
+    }
+  }
+}
+
+void
+bypipe(void)
+{
+  char buf[CHUNK];
+  int fds[2];
+
+  if(pipe(fds) < 0){
+    printf("shmbench: pipe failed\n");
+    exit(1);
+  }
+  int start = uptime();
+  int pid = fork();
+  if(pid < 0){
+    printf("shmbench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    close(fds[0]);
+    for(uint pos = 0; pos < TOTAL; pos += CHUNK){
+      fill(buf, pos);
+      if(write(fds[1], buf, CHUNK) != CHUNK){
+        printf("shmbench: write failed\n");
+        exit(1);
+      }
+    }
+    exit(0);
+  }
+  close(fds[1]);
+  for(uint pos = 0; pos < TOTAL; pos += CHUNK){
+    for(int n = 0; n < CHUNK; ){
+      int m = read(fds[0], buf + n, CHUNK - n);
+      if(m <= 0){
+        printf("shmbench: read failed\n");
+        exit(1);
+      }
+      n += m;
+    }
+    check(buf, pos);
+  }
+  close(fds[0]);
+  wait(0);
+  printf("pipe: %d KB in %d ticks\n", TOTAL / 1024, uptime() - start);
+}
+
+void
+byshm(void)
+{
+  int id = shmget(KEY, NPAGES);
+  char *base = (char*)SHMBASE;
+
+  if(id < 0 || shmat(id, base) != base){
+    printf("shmbench: shmget/shmat failed\n");
+    exit(1);
+  }
+  struct ring *r = (struct ring*)base;
+  char *data = base + PGSIZE;
+  r->head = r->tail = 0;
+
+  int start = uptime();
+  int pid = fork();
+  if(pid < 0){
+    printf("shmbench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    // the child inherits the attachment.
+    for(uint pos = 0; pos < TOTAL; pos += CHUNK){
+      while(r->head - r->tail > RING - CHUNK)
+        ;
+      fill(data + pos % RING, pos);
+      __sync_synchronize();
+      r->head = pos + CHUNK;
+    }
+    exit(0);
+  }
+  for(uint pos = 0; pos < TOTAL; pos += CHUNK){
+    while(r->head == pos)
+      ;
+    __sync_synchronize();
+    check(data + pos % RING, pos);
+    __sync_synchronize();
+    r->tail = pos + CHUNK;
+  }
+  wait(0);
+  printf("shm: %d KB in %d ticks\n", TOTAL / 1024, uptime() - start);
+  if(shmdt(base) < 0 || shmdt(base) == 0){
+    printf("shmbench: shmdt failed\n");
+    exit(1);
+  }
+}
+
+void
+lifetime(void)
+{
+  char *base = (char*)SHMBASE;
+  int id = shmget(KEY2, 1);
+
+  if(id < 0 || shmat(id, base) != base){
+    printf("shmbench: shmget/shmat failed\n");
+    exit(1);
+  }
+  base[0] = 42;
+  // a second id, not yet attached, keeps the segment.
+  if(shmget(KEY2, 1) != id || shmdt(base) < 0 ||
+     shmat(id, base) != base || base[0] != 42){
+    printf("shmbench: segment went away while held\n");
+    exit(1);
+  }
+  shmdt(base);
+}
+
+int
+main(int argc, char *argv[])
+{
+  bypipe();
+  byshm();
+  lifetime();
+  printf("shmbench: OK\n");
+  exit(0);
+}
@@ -0,0 +1,19 @@
+#include "kernel/types.h"
+#include "kernel/memstat.h"
+#include "user/user.h"
+
+// Print the counters of every slab cache: objects in use,
+// slab pages holding them, and how often the per-CPU
+// magazines had to go to the slabs.
+int
+main(int argc, char *argv[])
+{
+  struct slabstat st;
+
+  printf("cache\tsize\tinuse\tslabs\tallocs\tmisses\n");
+  for(int i = 0; getslabstat(i, &st) == 0; i++){
+    printf("%s\t%d\t%d\t%d\t%d\t%d\n", st.name, st.size,
+           st.nalloc - st.nfree, st.nslabs, st.nalloc, st.nmiss);
+  }
+  exit(0);
+}
@@ -0,0 +1,52 @@
+#include "kernel/types.h"
+#include "kernel/pgstat.h"
+#include "user/user.h"
+
+#define PGSIZE 4096
+#define NPAGES 28
+
+// Sparse-array benchmark for lazy sbrk().
+// Reserves NPAGES heap pages and touches every stride-th one,
+// then prints the page faults and swap traffic it caused.
+// With stride 1 every page is touched, which is what eager
+// allocation used to cost for any sbrk() of this size.
+void
+run(int stride)
+{
+  struct pgstat before, after;
+  int pid = fork();
+
+  if(pid == 0){
+    getpgstat(getpid(), &before);
+    int start = uptime();
+    char *a = sbrk(NPAGES * PGSIZE);
+    if(a == (char*)-1){
+      printf("sparse: sbrk failed\n");
+      exit(1);
+    }
+    for(int i = 0; i < NPAGES; i += stride)
+      a[i * PGSIZE] = i;
+    for(int i = 0; i < NPAGES; i += stride){
+      if(a[i * PGSIZE] != i){
+        printf("sparse: page %d lost its data\n", i);
+        exit(1);
+      }
+    }
+    getpgstat(getpid(), &after);
+    printf("stride %d: %d pages touched, %d faults, %d swap-outs, %d swap-ins, %d ticks\n",
+           stride, (NPAGES + stride - 1) / stride,
+           after.faults - before.faults, after.swapouts - before.swapouts,
+           after.swapins - before.swapins, uptime() - start);
+    exit(0);
+  }
+  wait(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  run(1);
+  run(4);
+  run(8);
+  exit(0);
+}
@@ -0,0 +1,37 @@
+#include "kernel/types.h"
+#include "kernel/swappolicy.h"
+#include "user/user.h"
+
+// swappolicy policy command [args...]
+// Runs command under the given page replacement policy, so that
+// the same workload can be compared across policies without
+// rebuilding the kernel.
+char *names[NSWAPPOLICY] = {
+[SWAP_NFUA]   "nfua",
+[SWAP_LAPA]   "lapa",
+[SWAP_SCFIFO] "scfifo",
+[SWAP_CLOCK]  "clock",
+[SWAP_ARC]    "arc",
+};
+
+int
+main(int argc, char *argv[])
+{
+  int i;
+
+  if(argc < 3){
+    fprintf(2, "usage: swappolicy nfua|lapa|scfifo|clock|arc command [args...]\n");
+    exit(1);
+  }
+  for(i = 0; i < NSWAPPOLICY; i++){
+    if(strcmp(argv[1], names[i]) == 0)
+      break;
+  }
+  if(i == NSWAPPOLICY || set_swap_policy(i) < 0){
+    fprintf(2, "swappolicy: bad policy %s\n", argv[1]);
+    exit(1);
+  }
+  exec(argv[2], argv + 2);
+  fprintf(2, "swappolicy: exec %s failed\n", argv[2]);
+  exit(1);
+}
@@ -1,4 +1,7 @@
 struct stat;
+struct pgstat;
+struct memstat;
+struct slabstat;
 
 // system calls
 int fork(void);
@@ -22,6 +25,15 @@ int getpid(void);
 char* sbrk(int);
 int sleep(int);
 int uptime(void);
+int getpgstat(int, struct pgstat*);
+int set_swap_policy(int);
+int set_paging_limits(int, int);
+int getmemstat(struct memstat*);
+int getslabstat(int, struct slabstat*);
+int madvise(void*, int, int);
+int shmget(int, int);
+void* shmat(int, void*);
+int shmdt(void*);
 
 // ulib.c
 int stat(const char*, struct stat*);
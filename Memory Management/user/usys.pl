@@ -36,3 +36,12 @@ entry("getpid");
 entry("sbrk");
 entry("sleep");
 entry("uptime");
+entry("getpgstat");
+entry("set_swap_policy");
+entry("set_paging_limits");
+entry("getmemstat");
+entry("getslabstat");
+entry("madvise");
+entry("shmget");
+entry("shmat");
+entry("shmdt");
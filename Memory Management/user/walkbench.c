@@ -0,0 +1,102 @@
+#include "kernel/types.h"
+#include "user/user.h"
+
+#define PGSIZE 4096
+#define NPAGES 12      // heap pages; stays under MAX_PSYC_PAGES
+#define PIPEBYTES (1024*1024)
+
+// Kernel page-walk benchmark.
+// Each workload makes the kernel touch many different physical
+// pages through its direct map, so the number of TLB misses it
+// takes depends on how that map is built:
+//   pipe  PIPEBYTES through a pipe, a byte at a time in the kernel
+//   zero  freshly sbrk()ed pages, each zeroed by the kernel
+//   fork  fork() of a process with NPAGES of heap
+// It prints the ticks each took.
+
+char buf[PGSIZE];
+
+static void
+pipework(void)
+{
+  int fds[2];
+
+  if(pipe(fds) < 0){
+    printf("walkbench: pipe failed\n");
+    exit(1);
+  }
+  int pid = fork();
+  if(pid < 0){
+    printf("walkbench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    close(fds[0]);
+    for(int n = 0; n < PIPEBYTES; n += sizeof(buf))
+      write(fds[1], buf, sizeof(buf));
+    exit(0);
+  }
+  close(fds[1]);
+  while(read(fds[0], buf, sizeof(buf)) > 0)
+    ;
+  close(fds[0]);
+  wait(0);
+}
+
+static void
+zerowork(void)
+{
+  for(int r = 0; r < 100; r++){
+    char *a = sbrk(NPAGES * PGSIZE);
+    if(a == (char*)-1){
+      printf("walkbench: sbrk failed\n");
+      exit(1);
+    }
+    for(int i = 0; i < NPAGES; i++)
+      a[i * PGSIZE] = 1;
+    sbrk(-NPAGES * PGSIZE);
+  }
+}
+
+static void
+forkwork(void)
+{
+  char *a = sbrk(NPAGES * PGSIZE);
+  if(a == (char*)-1){
+    printf("walkbench: sbrk failed\n");
+    exit(1);
+  }
+  for(int i = 0; i < NPAGES; i++)
+    a[i * PGSIZE] = 1;
+  for(int r = 0; r < 100; r++){
+    int pid = fork();
+    if(pid < 0){
+      printf("walkbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0)
+      exit(0);
+    wait(0);
+  }
+  sbrk(-NPAGES * PGSIZE);
+}
+
+struct {
+  char *name;
+  void (*fn)(void);
+} works[] = {
+  { "pipe", pipework },
+  { "zero", zerowork },
+  { "fork", forkwork },
+};
+
+int
+main(int argc, char *argv[])
+{
+  for(int i = 0; i < sizeof(works)/sizeof(works[0]); i++){
+    int start = uptime();
+    works[i].fn();
+    printf("%s\t%d ticks\n", works[i].name, uptime() - start);
+  }
+  exit(0);
+}
@@ -0,0 +1,70 @@
+#include "kernel/types.h"
+#include "kernel/pgstat.h"
+#include "kernel/swappolicy.h"
+#include "user/user.h"
+
+#define PGSIZE 4096
+#define HOT 16         // pages each child keeps using
+#define COLD 60        // cold pages of the first child; child i has i+1 times as many
+#define NCHILD 3
+#define TICKS 50       // ticks each child runs
+
+// Working-set and reclaim test.
+// Starts NCHILD processes under NFUA, each with HOT pages in use
+// and a growing number of pages it touched once, and prints
+// their resident and working-set sizes as they run, then the
+// pages global reclaim took from each. Memory is rarely short
+// enough for reclaim to start; build with a large RECLAIM_LOW
+// (say 32768) to see every child trimmed in proportion to its
+// cold pages.
+
+void
+child(int i)
+{
+  int cold = COLD * (i + 1);
+  int npages = HOT + cold;
+  struct pgstat st;
+
+  if(set_swap_policy(SWAP_NFUA) < 0 ||
+     set_paging_limits(npages + 16, npages + 16) < 0){
+    printf("wsbench: paging calls failed\n");
+    exit(1);
+  }
+  char *a = sbrk(npages * PGSIZE);
+  if(a == (char*)-1){
+    printf("wsbench: sbrk failed\n");
+    exit(1);
+  }
+  for(int j = 0; j < npages; j++)
+    a[j * PGSIZE] = j;
+  int start = uptime(), last = start;
+  while(uptime() - start < TICKS){
+    for(int j = 0; j < HOT; j++)
+      a[j * PGSIZE]++;
+    if(uptime() - last >= 10){
+      last = uptime();
+      getpgstat(getpid(), &st);
+      printf("%d\t%d\t%d\t%d\t%d\t%d\n", i, last - start, npages,
+             st.resident, st.wss, st.reclaimed);
+    }
+  }
+  exit(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf("child\tticks\tpages\tresident\twss\treclaimed\n");
+  for(int i = 0; i < NCHILD; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf("wsbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0)
+      child(i);
+  }
+  for(int i = 0; i < NCHILD; i++)
+    wait(0);
+  exit(0);
+}
@@ -2,6 +2,7 @@ struct buf;
 struct context;
 struct file;
 struct inode;
+struct lockstat;
 struct pipe;
 struct proc;
 struct spinlock;
@@ -64,6 +65,7 @@ void            ramdiskrw(struct buf*);
 void*           kalloc(void);
 void            kfree(void *);
 void            kinit(void);
+void            kmemstat(int*, int*);
 
 // log.c
 void            initlog(int, struct superblock*);
@@ -113,6 +115,9 @@ long long       find_min_acc(struct proc*); //ass1 task5
 void            update_stats(void); //ass1 task6
 int             get_cfs_stats(int pid, uint64 cfs_priority_adrr,uint64 rtime_addr,uint64 stime_addr,uint64 retime_addr); //ass1 task6
 int             set_policy(int); //ass1 task7
+int             getmeminfo(int, uint64);
+int             getloadinfo(uint64);
+int             set_sched_class(int);
 
 // swtch.S
 void            swtch(struct context*, struct context*);
@@ -124,6 +129,7 @@ void            initlock(struct spinlock*, char*);
 void            release(struct spinlock*);
 void            push_off(void);
 void            pop_off(void);
+int             lockbench(int, int, struct lockstat*);
 
 // sleeplock.c
 void            acquiresleep(struct sleeplock*);
@@ -180,6 +186,7 @@ uint64          walkaddr(pagetable_t, uint64);
 int             copyout(pagetable_t, uint64, char *, uint64);
 int             copyin(pagetable_t, char *, uint64, uint64);
 int             copyinstr(pagetable_t, char *, uint64, uint64);
+void            uvmstat(pagetable_t, int*, int*);
 
 // plic.c
 void            plicinit(void);
@@ -1,6 +1,11 @@
 // Physical memory allocator, for user processes,
 // kernel stacks, page-table pages,
 // and pipe buffers. Allocates whole 4096-byte pages.
+//
+// Each CPU keeps its own free list so that kalloc()/kfree()
+// normally touch only a per-CPU lock. Pages move between a
+// CPU's list and the global pool in batches of KMEM_BATCH,
+// and a CPU that finds both empty steals from its neighbours.
 
 #include "types.h"
 #include "param.h"
@@ -9,6 +14,9 @@
 #include "riscv.h"
 #include "defs.h"
 
+#define KMEM_BATCH   32               // pages moved per refill/drain
+#define KMEM_HIGH    (4*KMEM_BATCH)   // drain a CPU list above this
+
 void freerange(void *pa_start, void *pa_end);
 
 extern char end[]; // first address after kernel.
@@ -18,15 +26,26 @@ struct run {
   struct run *next;
 };
 
+// global pool, refilled by drains from the per-CPU lists.
 struct {
   struct spinlock lock;
   struct run *freelist;
+  int nfree;
 } kmem;
 
+// per-CPU free lists.
+struct {
+  struct spinlock lock;
+  struct run *freelist;
+  int nfree;
+} kmem_cpu[NCPU];
+
 void
 kinit()
 {
   initlock(&kmem.lock, "kmem");
+  for(int i = 0; i < NCPU; i++)
+    initlock(&kmem_cpu[i].lock, "kmem_cpu");
   freerange(end, (void*)PHYSTOP);
 }
 
@@ -39,6 +58,42 @@ freerange(void *pa_start, void *pa_end)
     kfree(p);
 }
 
+// Detach up to n pages from the front of *list.
+// Returns the detached chain; *got is set to its length.
+static struct run*
+take(struct run **list, int n, int *got)
+{
+  struct run *head, *tail;
+  int i;
+
+  head = *list;
+  if(head == 0){
+    *got = 0;
+    return 0;
+  }
+  tail = head;
+  for(i = 1; i < n && tail->next; i++)
+    tail = tail->next;
+  *list = tail->next;
+  tail->next = 0;
+  *got = i;
+  return head;
+}
+
+// Prepend the chain starting at head to *list.
+static void
+give(struct run **list, struct run *head)
+{
+  struct run *tail;
+
+  if(head == 0)
+    return;
+  for(tail = head; tail->next; tail = tail->next)
+    ;
+  tail->next = *list;
+  *list = head;
+}
+
 // Free the page of physical memory pointed at by pa,
 // which normally should have been returned by a
 // call to kalloc().  (The exception is when
@@ -46,7 +101,8 @@ freerange(void *pa_start, void *pa_end)
 void
 kfree(void *pa)
 {
-  struct run *r;
+  struct run *r, *batch = 0;
+  int id, n = 0;
 
   if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
     panic("kfree");
@@ -56,10 +112,76 @@ kfree(void *pa)
 
   r = (struct run*)pa;
 
+  push_off();
+  id = cpuid();
+  acquire(&kmem_cpu[id].lock);
+  r->next = kmem_cpu[id].freelist;
+  kmem_cpu[id].freelist = r;
+  kmem_cpu[id].nfree++;
+  if(kmem_cpu[id].nfree > KMEM_HIGH){
+    batch = take(&kmem_cpu[id].freelist, KMEM_BATCH, &n);
+    kmem_cpu[id].nfree -= n;
+  }
+  release(&kmem_cpu[id].lock);
+
+  if(batch){
+    acquire(&kmem.lock);
+    give(&kmem.freelist, batch);
+    kmem.nfree += n;
+    release(&kmem.lock);
+  }
+  pop_off();
+}
+
+// Refill CPU id's empty list, first from the global pool,
+// then by stealing half of another CPU's list.
+// Returns one page for the caller, or 0 if memory is exhausted.
+static struct run*
+refill(int id)
+{
+  struct run *batch;
+  int i, n;
+
   acquire(&kmem.lock);
-  r->next = kmem.freelist;
-  kmem.freelist = r;
+  batch = take(&kmem.freelist, KMEM_BATCH, &n);
+  kmem.nfree -= n;
   release(&kmem.lock);
+
+  for(i = 1; batch == 0 && i < NCPU; i++){
+    int victim = (id + i) % NCPU;
+    acquire(&kmem_cpu[victim].lock);
+    batch = take(&kmem_cpu[victim].freelist,
+                 (kmem_cpu[victim].nfree + 1) / 2, &n);
+    kmem_cpu[victim].nfree -= n;
+    release(&kmem_cpu[victim].lock);
+  }
+
+  if(batch == 0)
+    return 0;
+
+  // keep the first page, stash the rest locally.
+  if(batch->next){
+    acquire(&kmem_cpu[id].lock);
+    give(&kmem_cpu[id].freelist, batch->next);
+    kmem_cpu[id].nfree += n - 1;
+    release(&kmem_cpu[id].lock);
+  }
+  batch->next = 0;
+  return batch;
+}
+
+// Report the number of free and allocated physical pages.
+// The per-CPU counts are read without their locks, so the
+// result is a snapshot that may be off by a batch in flight.
+void
+kmemstat(int *freepages, int *usedpages)
+{
+  int n = kmem.nfree;
+
+  for(int i = 0; i < NCPU; i++)
+    n += kmem_cpu[i].nfree;
+  *freepages = n;
+  *usedpages = (PHYSTOP - PGROUNDUP((uint64)end)) / PGSIZE - n;
 }
 
 // Allocate one 4096-byte page of physical memory.
@@ -69,12 +191,21 @@ void *
 kalloc(void)
 {
   struct run *r;
+  int id;
 
-  acquire(&kmem.lock);
-  r = kmem.freelist;
-  if(r)
-    kmem.freelist = r->next;
-  release(&kmem.lock);
+  push_off();
+  id = cpuid();
+  acquire(&kmem_cpu[id].lock);
+  r = kmem_cpu[id].freelist;
+  if(r){
+    kmem_cpu[id].freelist = r->next;
+    kmem_cpu[id].nfree--;
+  }
+  release(&kmem_cpu[id].lock);
+
+  if(r == 0)
+    r = refill(id);
+  pop_off();
 
   if(r)
     memset((char*)r, 5, PGSIZE); // fill with junk
@@ -0,0 +1,10 @@
+// Load averages and per-hart utilization, as reported by getloadinfo().
+// Load averages are fixed-point numbers with FSHIFT fraction bits.
+#define FSHIFT   11              // bits of precision
+#define FIXED_1  (1<<FSHIFT)     // 1.0 in fixed point
+
+struct loadinfo {
+  uint loadavg[3];     // Decayed run-queue length, 1/5/15-tick windows
+  uint64 busy[NCPU];   // Timer cycles each hart spent running a process
+  uint64 idle[NCPU];   // Timer cycles each hart spent in scheduler()
+};
@@ -0,0 +1,12 @@
+// Memory usage of one process, plus system-wide page counts,
+// as reported by getmeminfo().
+struct meminfo {
+  uint64 sz;       // Size of process memory (bytes), as memsize()
+  int resident;    // User pages actually mapped
+  int ptpages;     // Page-table pages
+  int kpages;      // Kernel stack and trapframe pages
+  int shared;      // Pages also mapped by other processes
+  int private;     // Pages mapped only by this process
+  int freepages;   // Free physical pages, system-wide
+  int usedpages;   // Allocated physical pages, system-wide
+};
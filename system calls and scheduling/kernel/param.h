@@ -11,3 +11,5 @@
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
 #define FSSIZE       2000  // size of file system in blocks
 #define MAXPATH      128   // maximum file path name
+#define SCHED_NORMAL   0   // scheduling class: competes for the CPU
+#define SCHED_IDLE     1   // scheduling class: runs only when nothing else can
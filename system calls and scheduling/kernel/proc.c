@@ -5,6 +5,8 @@
 #include "spinlock.h"
 #include "proc.h"
 #include "defs.h"
+#include "meminfo.h"
+#include "loadinfo.h"
 #include <limits.h>
 
 struct cpu cpus[NCPU];
@@ -23,6 +25,14 @@ extern char trampoline[]; // trampoline.S
 
 int sched_policy = 0; //ass1 task7
 
+// exponentially-decayed run-queue length over 1, 5 and 15 tick
+// windows, in FSHIFT fixed point. written by update_stats()
+// under tickslock.
+uint loadavg[3];
+
+// per-tick decay factors, FIXED_1 * exp(-1/window).
+static const uint loadexp[3] = { 753, 1677, 1916 };
+
 // helps ensure that wakeups of wait()ing
 // parents are not lost. helps obey the
 // memory model when using p->parent.
@@ -132,6 +142,8 @@ found:
   p->ps_priority = 5; 
   p->accumulator = find_min_acc(p);
 
+  p->sched_class = SCHED_NORMAL;
+
   //ass1 task6
   p->cfs_priority = 1;
   p->rtime=0;
@@ -326,6 +338,7 @@ fork(void)
   safestrcpy(np->name, p->name, sizeof(p->name));
 
   np->cfs_priority=p->cfs_priority; //ass1 task6
+  np->sched_class = p->sched_class;
 
   pid = np->pid;
 
@@ -459,6 +472,42 @@ wait(uint64 addr, uint64 msg_addr)
   }
 }
 
+// Run p on this CPU if it is still RUNNABLE.
+// Returns when p gives the CPU back.
+static void
+runproc(struct cpu *c, struct proc *p)
+{
+  acquire(&p->lock);
+  if(p->state == RUNNABLE){
+    p->state = RUNNING;
+    c->proc = p;
+    swtch(&c->context, &p->context);
+    c->proc = 0;
+  }
+  release(&p->lock);
+}
+
+// Find a RUNNABLE process in the SCHED_IDLE class, starting
+// after the one c picked last time so idle processes take turns.
+// Returns 0 if there is none.
+static struct proc*
+pick_idle(struct cpu *c)
+{
+  struct proc *p;
+
+  for(int i = 1; i <= NPROC; i++){
+    p = &proc[(c->lastidle + i) % NPROC];
+    acquire(&p->lock);
+    if(p->state == RUNNABLE && p->sched_class == SCHED_IDLE){
+      release(&p->lock);
+      c->lastidle = p - proc;
+      return p;
+    }
+    release(&p->lock);
+  }
+  return 0;
+}
+
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
 // Scheduler never returns.  It loops, doing:
@@ -466,6 +515,8 @@ wait(uint64 addr, uint64 msg_addr)
 //  - swtch to start running that process.
 //  - eventually that process transfers control
 //    via swtch back to the scheduler.
+// SCHED_IDLE processes are skipped by every policy, and only
+// run when a pass finds no other RUNNABLE process.
 
 void
 scheduler(void){
@@ -476,11 +527,12 @@ scheduler(void){
     // Avoid deadlock by ensuring that devices can interrupt.
     intr_on();
     struct proc* min_proc = 0;
+    int ran = 0;
     
     if(sched_policy==0){ //default scheduler
       for(p = proc; p < &proc[NPROC]; p++) {
         acquire(&p->lock);
-        if(p->state == RUNNABLE) {
+        if(p->state == RUNNABLE && p->sched_class != SCHED_IDLE) {
           // Switch to chosen process.  It is the process's job
           // to release its lock and then reacquire it
           // before jumping back to us.
@@ -491,6 +543,7 @@ scheduler(void){
           // Process is done running for now.
           // It should have changed its p->state before coming back.
           c->proc = 0;
+          ran = 1;
         }
         release(&p->lock);
       }
@@ -501,7 +554,7 @@ scheduler(void){
       long long min_acc = LLONG_MAX;
       for(p = proc; p< &proc[NPROC];p++){
         acquire(&p->lock);
-        if(p->state == RUNNABLE && p->accumulator < min_acc){
+        if(p->state == RUNNABLE && p->sched_class != SCHED_IDLE && p->accumulator < min_acc){
             min_acc = p->accumulator;
             min_proc = p;
           }
@@ -524,7 +577,7 @@ scheduler(void){
       int min_vruntime = INT_MAX;
       for(p = proc; p < &proc[NPROC]; p++){
         acquire(&p->lock);
-        if(p->state == RUNNABLE){
+        if(p->state == RUNNABLE && p->sched_class != SCHED_IDLE){
           int decay_factor = 75 + (p->cfs_priority * 25);
           int vruntime = decay_factor * ((p->rtime) / (p->rtime + p->stime + p->retime + 1));
           if(vruntime < min_vruntime){
@@ -545,6 +598,10 @@ scheduler(void){
         release(&min_proc->lock);
       }
     }
+
+    // nothing else wanted the CPU: give it to an idle-class process.
+    if(!ran && min_proc == 0 && (p = pick_idle(c)) != 0)
+      runproc(c, p);
   }
 }
 
@@ -699,6 +756,21 @@ int set_ps_priority(int ps_priority){
   }
 }
 
+// Move the calling process into scheduling class cls,
+// SCHED_NORMAL or SCHED_IDLE.
+int
+set_sched_class(int cls)
+{
+  struct proc *p = myproc();
+
+  if(cls != SCHED_NORMAL && cls != SCHED_IDLE)
+    return -1;
+  acquire(&p->lock);
+  p->sched_class = cls;
+  release(&p->lock);
+  return 0;
+}
+
 int set_cfs_priority(int cfs_priority){
   struct proc *p = myproc();
   if(cfs_priority<0 || cfs_priority>2){
@@ -860,19 +932,78 @@ int get_cfs_stats(int pid, uint64 cfs_priority_adrr,uint64 rtime_addr,uint64 sti
 //ass1 task6
 void update_stats(void){
   struct proc *p;
+  uint nrun = 0;
   for(p = proc; p < &proc[NPROC]; p++){
     acquire(&p->lock);
     if(p->state==RUNNABLE){
       p->retime+=1;
+      nrun++;
     }
     else if(p->state==SLEEPING){
       p->stime+=1;
     }
     else if(p->state==RUNNING){
       p->rtime+=1;
+      nrun++;
     }
     release(&p->lock);
   }
+
+  // fold this tick's run-queue length into the load averages.
+  for(int i = 0; i < 3; i++)
+    loadavg[i] = (loadavg[i] * loadexp[i] + nrun * FIXED_1 * (FIXED_1 - loadexp[i])) >> FSHIFT;
+}
+
+// Copy the load averages and per-hart busy/idle cycle counts
+// out to addr in the caller's address space.
+int
+getloadinfo(uint64 addr)
+{
+  struct loadinfo li;
+
+  acquire(&tickslock);
+  for(int i = 0; i < 3; i++)
+    li.loadavg[i] = loadavg[i];
+  release(&tickslock);
+
+  // the cycle counts are only written by their own hart;
+  // a slightly stale read is fine.
+  for(int i = 0; i < NCPU; i++){
+    li.busy[i] = cpus[i].busy;
+    li.idle[i] = cpus[i].idle;
+  }
+  return copyout(myproc()->pagetable, addr, (char*)&li, sizeof(li));
+}
+
+// Fill in a struct meminfo for process pid and copy it
+// out to addr in the caller's address space.
+// This tree never shares user pages between processes,
+// so only the trampoline page is counted as shared.
+int
+getmeminfo(int pid, uint64 addr)
+{
+  struct proc *my_p = myproc();
+  struct proc *p;
+  struct meminfo mi;
+
+  memset(&mi, 0, sizeof(mi));
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED && p->pagetable){
+      mi.sz = p->sz;
+      uvmstat(p->pagetable, &mi.ptpages, &mi.resident);
+      mi.kpages = 2; // kernel stack and trapframe
+      mi.shared = 1; // trampoline
+      mi.private = mi.resident + mi.ptpages + mi.kpages;
+      release(&p->lock);
+      kmemstat(&mi.freepages, &mi.usedpages);
+      if(copyout(my_p->pagetable, addr, (char*)&mi, sizeof(mi)) < 0)
+        return -1;
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
 }
 
 int set_policy(int policy){
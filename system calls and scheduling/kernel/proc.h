@@ -24,6 +24,10 @@ struct cpu {
   struct context context;     // swtch() here to enter scheduler().
   int noff;                   // Depth of push_off() nesting.
   int intena;                 // Were interrupts enabled before push_off()?
+  uint64 busy;                // Timer cycles spent running a process.
+  uint64 idle;                // Timer cycles spent with no process.
+  uint64 lastsample;          // r_time() at the last timer interrupt.
+  int lastidle;               // proc[] index of the last SCHED_IDLE process run here.
 };
 
 extern struct cpu cpus[NCPU];
@@ -98,6 +102,7 @@ struct proc {
   int rtime; //ass1 task6
   int stime; //ass1 task6
   int retime; //ass1 task6
+  int sched_class;             // SCHED_NORMAL or SCHED_IDLE
 
   
 
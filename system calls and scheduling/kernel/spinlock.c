@@ -12,7 +12,8 @@ void
 initlock(struct spinlock *lk, char *name)
 {
   lk->name = name;
-  lk->locked = 0;
+  lk->next = 0;
+  lk->owner = 0;
   lk->cpu = 0;
 }
 
@@ -21,15 +22,19 @@ initlock(struct spinlock *lk, char *name)
 void
 acquire(struct spinlock *lk)
 {
+  uint ticket;
+
   push_off(); // disable interrupts to avoid deadlock.
   if(holding(lk))
     panic("acquire");
 
-  // On RISC-V, sync_lock_test_and_set turns into an atomic swap:
+  // On RISC-V, sync_fetch_and_add turns into an atomic add:
   //   a5 = 1
-  //   s1 = &lk->locked
-  //   amoswap.w.aq a5, a5, (s1)
-  while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
+  //   s1 = &lk->next
+  //   amoadd.w.aqrl a5, a5, (s1)
+  // Waiters then only load owner, which is written once per release.
+  ticket = __sync_fetch_and_add(&lk->next, 1);
+  while(*(volatile uint *)&lk->owner != ticket)
     ;
 
   // Tell the C compiler and the processor to not move loads or stores
@@ -59,14 +64,10 @@ release(struct spinlock *lk)
   // On RISC-V, this emits a fence instruction.
   __sync_synchronize();
 
-  // Release the lock, equivalent to lk->locked = 0.
-  // This code doesn't use a C assignment, since the C standard
-  // implies that an assignment might be implemented with
-  // multiple store instructions.
-  // On RISC-V, sync_lock_release turns into an atomic swap:
-  //   s1 = &lk->locked
-  //   amoswap.w zero, zero, (s1)
-  __sync_lock_release(&lk->locked);
+  // Release the lock by serving the next ticket.
+  // Only the holder writes owner, so a plain load is safe;
+  // the volatile store keeps it a single store instruction.
+  *(volatile uint *)&lk->owner = lk->owner + 1;
 
   pop_off();
 }
@@ -77,7 +78,7 @@ int
 holding(struct spinlock *lk)
 {
   int r;
-  r = (lk->locked && lk->cpu == mycpu());
+  r = (lk->next != lk->owner && lk->cpu == mycpu());
   return r;
 }
 
@@ -108,3 +109,51 @@ pop_off(void)
   if(c->noff == 0 && c->intena)
     intr_on();
 }
+
+// Test-and-set lock, kept only so lockbench() can compare the
+// ticket lock above against the lock it replaced.
+static uint taslock;
+static struct spinlock benchlock = { .name = "lockbench" };
+
+// Hammer a shared lock iters times from the calling CPU and
+// report throughput and the longest wait to acquire.
+// kind 0 uses the ticket lock, kind 1 the test-and-set lock.
+// Returns 0 on success, -1 on a bad argument.
+int
+lockbench(int kind, int iters, struct lockstat *st)
+{
+  uint64 start, t0, wait;
+  int i;
+
+  if(kind < 0 || kind > 1 || iters < 0)
+    return -1;
+
+  st->acquires = 0;
+  st->maxwait = 0;
+
+  start = r_time();
+  for(i = 0; i < iters; i++){
+    t0 = r_time();
+    if(kind == 0){
+      acquire(&benchlock);
+    } else {
+      push_off();
+      while(__sync_lock_test_and_set(&taslock, 1) != 0)
+        ;
+      __sync_synchronize();
+    }
+    wait = r_time() - t0;
+    if(wait > st->maxwait)
+      st->maxwait = wait;
+    st->acquires++;
+    if(kind == 0){
+      release(&benchlock);
+    } else {
+      __sync_synchronize();
+      __sync_lock_release(&taslock);
+      pop_off();
+    }
+  }
+  st->cycles = r_time() - start;
+  return 0;
+}
@@ -1,9 +1,19 @@
 // Mutual exclusion lock.
+// A ticket lock: acquirers take the next ticket and spin until
+// owner reaches it, so waiters are served in FIFO order and only
+// read the shared owner word while they wait.
 struct spinlock {
-  uint locked;       // Is the lock held?
+  uint next;         // Next ticket to hand out.
+  uint owner;        // Ticket currently allowed to hold the lock.
 
   // For debugging:
   char *name;        // Name of lock.
   struct cpu *cpu;   // The cpu holding the lock.
 };
 
+// Result of one lockbench() run, filled in for user space.
+struct lockstat {
+  uint64 acquires;   // Number of acquire/release pairs done.
+  uint64 cycles;     // Total time spent, in timer cycles.
+  uint64 maxwait;    // Longest single wait to acquire.
+};
@@ -106,6 +106,10 @@ extern uint64 sys_set_ps_priority(void); //ass1 task5
 extern uint64 sys_set_cfs_priority(void);  //ass1 task6
 extern uint64 sys_get_cfs_stats(void); //ass1 task6
 extern uint64 sys_set_policy(void); //ass1 task7
+extern uint64 sys_lockbench(void);
+extern uint64 sys_getmeminfo(void);
+extern uint64 sys_getloadinfo(void);
+extern uint64 sys_set_sched_class(void);
 
 
 // An array mapping syscall numbers from syscall.h
@@ -137,6 +141,10 @@ static uint64 (*syscalls[])(void) = {
 [SYS_set_cfs_priority]   sys_set_cfs_priority, //ass1 task6
 [SYS_get_cfs_stats]   sys_get_cfs_stats, //ass1 task6
 [SYS_set_policy] sys_set_policy, //ass1 task7
+[SYS_lockbench] sys_lockbench,
+[SYS_getmeminfo] sys_getmeminfo,
+[SYS_getloadinfo] sys_getloadinfo,
+[SYS_set_sched_class] sys_set_sched_class,
 
 };
 
@@ -24,4 +24,8 @@
 #define SYS_set_ps_priority  23   //ass1 task5
 #define SYS_set_cfs_priority  24   //ass1 task6
 #define SYS_get_cfs_stats 25   //ass1 task6
-#define SYS_set_policy 26 //ass1 task7
\ No newline at end of file
+#define SYS_set_policy 26 //ass1 task7
+#define SYS_lockbench 27
+#define SYS_getmeminfo 28
+#define SYS_getloadinfo 29
+#define SYS_set_sched_class 30
\ No newline at end of file
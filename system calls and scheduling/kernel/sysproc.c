@@ -104,6 +104,37 @@ sys_memsize(void)
   return size;
 }
 
+// report memory usage of a process; see struct meminfo.
+uint64
+sys_getmeminfo(void)
+{
+  int pid;
+  uint64 addr;
+
+  argint(0, &pid);
+  argaddr(1, &addr);
+  return getmeminfo(pid, addr);
+}
+
+// report load averages and per-hart utilization; see struct loadinfo.
+uint64
+sys_getloadinfo(void)
+{
+  uint64 addr;
+
+  argaddr(0, &addr);
+  return getloadinfo(addr);
+}
+
+uint64
+sys_set_sched_class(void)
+{
+  int cls;
+
+  argint(0, &cls);
+  return set_sched_class(cls);
+}
+
 //ass1 task5
 uint64
 sys_set_ps_priority(void)
@@ -146,4 +177,23 @@ sys_set_policy(void)
   int policy;
   argint(0, &policy);
   return set_policy(policy);
+}
+
+// run the spinlock contention benchmark on this CPU
+// and copy its struct lockstat out to user space.
+uint64
+sys_lockbench(void)
+{
+  int kind, iters;
+  uint64 addr;
+  struct lockstat st;
+
+  argint(0, &kind);
+  argint(1, &iters);
+  argaddr(2, &addr);
+  if(lockbench(kind, iters, &st) < 0)
+    return -1;
+  if(copyout(myproc()->pagetable, addr, (char*)&st, sizeof(st)) < 0)
+    return -1;
+  return 0;
 }
\ No newline at end of file
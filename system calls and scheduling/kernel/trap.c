@@ -184,6 +184,24 @@ kerneltrap()
   w_sstatus(sstatus);
 }
 
+// Charge the time since this hart's previous timer interrupt
+// to busy or idle, depending on whether a process is running.
+// Runs on every hart; clockintr() only runs on hart 0.
+static void
+cpuacct(void)
+{
+  struct cpu *c = mycpu();
+  uint64 now = r_time();
+
+  if(c->lastsample){
+    if(c->proc)
+      c->busy += now - c->lastsample;
+    else
+      c->idle += now - c->lastsample;
+  }
+  c->lastsample = now;
+}
+
 void
 clockintr()
 {
@@ -234,7 +252,8 @@ devintr()
     if(cpuid() == 0){
       clockintr();
     }
-    
+    cpuacct();
+
     // acknowledge the software interrupt by clearing
     // the SSIP bit in sip.
     w_sip(r_sip() & ~2);
@@ -286,6 +286,23 @@ freewalk(pagetable_t pagetable)
   kfree((void*)pagetable);
 }
 
+// Count the page-table pages of pagetable into *ptpages,
+// and the user (PTE_U) pages it maps into *upages.
+void
+uvmstat(pagetable_t pagetable, int *ptpages, int *upages)
+{
+  *ptpages += 1;
+  for(int i = 0; i < 512; i++){
+    pte_t pte = pagetable[i];
+    if((pte & PTE_V) && (pte & (PTE_R|PTE_W|PTE_X)) == 0){
+      // this PTE points to a lower-level page table.
+      uvmstat((pagetable_t)PTE2PA(pte), ptpages, upages);
+    } else if((pte & PTE_V) && (pte & PTE_U)){
+      *upages += 1;
+    }
+  }
+}
+
 // Free user memory pages,
 // then free page-table pages.
 void
@@ -0,0 +1,80 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+// Parallel page-allocator benchmark.
+// Starts nworkers processes that each grow and shrink their heap
+// with sbrk() and fork short-lived children, so every iteration goes
+// through kalloc()/kfree(). Run it with different CPUS= settings and
+// compare the pages/tick figure to see how allocation scales.
+//
+// usage: allocbench [nworkers] [rounds]
+
+#define PAGES_PER_ROUND 64
+#define FORKS_PER_ROUND 4
+
+void
+worker(int rounds)
+{
+  for(int r = 0; r < rounds; r++){
+    char *p = sbrk(PAGES_PER_ROUND * 4096);
+    if(p == (char*)-1){
+      printf("allocbench: sbrk failed\n");
+      exit(1,"");
+    }
+    // touch each page so the benchmark measures real work.
+    for(int i = 0; i < PAGES_PER_ROUND; i++)
+      p[i * 4096] = r;
+    sbrk(-(PAGES_PER_ROUND * 4096));
+
+    for(int i = 0; i < FORKS_PER_ROUND; i++){
+      int pid = fork();
+      if(pid < 0){
+        printf("allocbench: fork failed\n");
+        exit(1,"");
+      }
+      if(pid == 0)
+        exit(0,"");
+      wait(0,0);
+    }
+  }
+  exit(0,"");
+}
+
+int
+main(int argc, char *argv[])
+{
+  int nworkers = 3;
+  int rounds = 200;
+
+  if(argc > 1)
+    nworkers = atoi(argv[1]);
+  if(argc > 2)
+    rounds = atoi(argv[2]);
+  if(nworkers < 1)
+    nworkers = 1;
+
+  int start = uptime();
+  for(int i = 0; i < nworkers; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf("allocbench: fork failed\n");
+      exit(1,"");
+    }
+    if(pid == 0)
+      worker(rounds);
+  }
+  for(int i = 0; i < nworkers; i++)
+    wait(0,0);
+  int elapsed = uptime() - start;
+  if(elapsed == 0)
+    elapsed = 1;
+
+  // each round allocates PAGES_PER_ROUND heap pages, and each fork
+  // allocates at least a trapframe, page-table pages and a copy
+  // of the worker's memory.
+  int pages = nworkers * rounds * PAGES_PER_ROUND;
+  printf("allocbench: %d workers, %d rounds, %d ticks\n", nworkers, rounds, elapsed);
+  printf("allocbench: %d heap pages, %d pages/tick\n", pages, pages / elapsed);
+  exit(0,"");
+}
@@ -0,0 +1,23 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+// Run a command in the SCHED_IDLE class, so it only gets
+// a CPU when no other process wants one.
+// usage: idle command [args...]
+int
+main(int argc, char *argv[])
+{
+  if(argc < 2){
+    fprintf(2, "usage: idle command [args...]\n");
+    exit(1,"");
+  }
+  if(set_sched_class(SCHED_IDLE) < 0){
+    fprintf(2, "idle: set_sched_class failed\n");
+    exit(1,"");
+  }
+  exec(argv[1], argv + 1);
+  fprintf(2, "idle: exec %s failed\n", argv[1]);
+  exit(1,"");
+}
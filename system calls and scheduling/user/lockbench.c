@@ -0,0 +1,83 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/spinlock.h"
+#include "user/user.h"
+
+// Spinlock contention benchmark.
+// Runs nprocs processes that all hammer one kernel lock at once,
+// first with the ticket lock and then with the old test-and-set
+// lock, and prints throughput and the worst wait seen by any
+// process. Use nprocs >= CPUS to get real contention.
+//
+// usage: lockbench [nprocs] [iters]
+
+char *names[] = { "ticket", "tas" };
+
+void
+run(int kind, int nprocs, int iters)
+{
+  struct lockstat st, total;
+  int fds[2];
+
+  if(pipe(fds) < 0){
+    printf("lockbench: pipe failed\n");
+    exit(1,"");
+  }
+  for(int i = 0; i < nprocs; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf("lockbench: fork failed\n");
+      exit(1,"");
+    }
+    if(pid == 0){
+      close(fds[0]);
+      if(lockbench(kind, iters, &st) < 0){
+        printf("lockbench: lockbench(%d) failed\n", kind);
+        exit(1,"");
+      }
+      write(fds[1], &st, sizeof(st));
+      exit(0,"");
+    }
+  }
+  close(fds[1]);
+
+  total.acquires = 0;
+  total.cycles = 0;
+  total.maxwait = 0;
+  for(int i = 0; i < nprocs; i++){
+    if(read(fds[0], &st, sizeof(st)) != sizeof(st))
+      break;
+    total.acquires += st.acquires;
+    if(st.cycles > total.cycles)
+      total.cycles = st.cycles;
+    if(st.maxwait > total.maxwait)
+      total.maxwait = st.maxwait;
+  }
+  close(fds[0]);
+  for(int i = 0; i < nprocs; i++)
+    wait(0,0);
+
+  if(total.cycles == 0)
+    total.cycles = 1;
+  printf("%s: %d acquires in %d cycles, %d acquires/Mcycle, max wait %d cycles\n",
+         names[kind], (int)total.acquires, (int)total.cycles,
+         (int)(total.acquires * 1000000 / total.cycles), (int)total.maxwait);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int nprocs = 3;
+  int iters = 100000;
+
+  if(argc > 1)
+    nprocs = atoi(argv[1]);
+  if(argc > 2)
+    iters = atoi(argv[2]);
+  if(nprocs < 1)
+    nprocs = 1;
+
+  run(0, nprocs, iters);
+  run(1, nprocs, iters);
+  exit(0,"");
+}
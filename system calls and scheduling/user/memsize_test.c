@@ -1,17 +1,54 @@
 #include "kernel/types.h"
 #include "kernel/stat.h"
+#include "kernel/meminfo.h"
 #include "user/user.h"
 
+void
+print_meminfo(struct meminfo *mi)
+{
+  printf("  sz %d resident %d ptpages %d kpages %d shared %d private %d\n",
+         (int)mi->sz, mi->resident, mi->ptpages, mi->kpages, mi->shared, mi->private);
+  printf("  system: %d free pages, %d used pages\n", mi->freepages, mi->usedpages);
+}
+
 int
 main(int argc, char *argv[])
 {
+  struct meminfo before, after;
+  int pid = getpid();
+
   int size= memsize();
   //write(1, &size, sizeof(size));
   //write(1, "\n", strlen("\n"));
   printf("the process is using %d bytes\n", size);
+  if(getmeminfo(pid, &before) < 0){
+    printf("getmeminfo failed\n");
+    exit(1,"");
+  }
+  print_meminfo(&before);
+  if(before.sz != size){
+    printf("getmeminfo: sz %d does not match memsize %d\n", (int)before.sz, size);
+    exit(1,"");
+  }
+
   char* ptr= malloc(20000);
   size= memsize();
   printf("the process is using %d bytes after the allocation\n", size);
+  getmeminfo(pid, &after);
+  print_meminfo(&after);
+  if(after.resident < before.resident + 20000/4096){
+    printf("getmeminfo: resident pages did not grow with the allocation\n");
+    exit(1,"");
+  }
+  if(after.freepages >= before.freepages){
+    printf("getmeminfo: free pages did not drop with the allocation\n");
+    exit(1,"");
+  }
+  if(getmeminfo(-1, &after) == 0){
+    printf("getmeminfo: succeeded for a bad pid\n");
+    exit(1,"");
+  }
+
   free(ptr);
   size= memsize();
   printf("the process is using %d bytes after the release\n", size);
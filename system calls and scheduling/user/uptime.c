@@ -0,0 +1,40 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/loadinfo.h"
+#include "user/user.h"
+
+// print a fixed-point load average as n.nn
+void
+printload(uint l)
+{
+  uint hundredths = ((l & (FIXED_1-1)) * 100) >> FSHIFT;
+  printf("%d.%s%d", l >> FSHIFT, hundredths < 10 ? "0" : "", hundredths);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct loadinfo li;
+
+  if(getloadinfo(&li) < 0){
+    fprintf(2, "uptime: getloadinfo failed\n");
+    exit(1,"");
+  }
+
+  printf("up %d ticks, load average: ", uptime());
+  printload(li.loadavg[0]);
+  printf(", ");
+  printload(li.loadavg[1]);
+  printf(", ");
+  printload(li.loadavg[2]);
+  printf("\n");
+
+  for(int i = 0; i < NCPU; i++){
+    uint64 total = li.busy[i] + li.idle[i];
+    if(total == 0)
+      continue;
+    printf("hart %d: %d%% busy\n", i, (int)(li.busy[i] * 100 / total));
+  }
+  exit(0,"");
+}
@@ -1,4 +1,7 @@
 struct stat;
+struct lockstat;
+struct meminfo;
+struct loadinfo;
 
 // system calls
 int fork(void);
@@ -27,6 +30,10 @@ int set_ps_priority(int); //ass1 task5 changed the signuture to int- will return
 int set_cfs_priority(int); //ass1 task6
 int get_cfs_stats(int,int*,int*,int*,int*); //ass1 task6
 int set_policy(int); //ass1 task7
+int lockbench(int, int, struct lockstat*);
+int getmeminfo(int, struct meminfo*);
+int getloadinfo(struct loadinfo*);
+int set_sched_class(int);
 
 
 // ulib.c
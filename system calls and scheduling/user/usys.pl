@@ -40,4 +40,8 @@ entry("memsize");
 entry("set_ps_priority");
 entry("set_cfs_priority");
 entry("get_cfs_stats");
-entry("set_policy");
\ No newline at end of file
+entry("set_policy");
+entry("lockbench");
+entry("getmeminfo");
+entry("getloadinfo");
+entry("set_sched_class");
\ No newline at end of file